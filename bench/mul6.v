@@ -0,0 +1,114 @@
+// 6x6 array multiplier
+module mul6(a, b, p);
+  input [5:0] a, b;
+  output [11:0] p;
+  wire r0_0, r0_1, r0_2, r0_3, r0_4, r0_5, pp1_0, s1_0, c1_0, pp1_1, s1_1, c1_1, pp1_2, s1_2, c1_2, pp1_3, s1_3, c1_3, pp1_4, s1_4, c1_4, pp1_5, s1_5, c1_5, pp2_0, s2_0, c2_0, pp2_1, s2_1, c2_1, pp2_2, s2_2, c2_2, pp2_3, s2_3, c2_3, pp2_4, s2_4, c2_4, pp2_5, s2_5, c2_5, pp3_0, s3_0, c3_0, pp3_1, s3_1, c3_1, pp3_2, s3_2, c3_2, pp3_3, s3_3, c3_3, pp3_4, s3_4, c3_4, pp3_5, s3_5, c3_5, pp4_0, s4_0, c4_0, pp4_1, s4_1, c4_1, pp4_2, s4_2, c4_2, pp4_3, s4_3, c4_3, pp4_4, s4_4, c4_4, pp4_5, s4_5, c4_5, pp5_0, s5_0, c5_0, pp5_1, s5_1, c5_1, pp5_2, s5_2, c5_2, pp5_3, s5_3, c5_3, pp5_4, s5_4, c5_4, pp5_5, s5_5, c5_5;
+  assign r0_0 = a[0] & b[0];
+  assign r0_1 = a[1] & b[0];
+  assign r0_2 = a[2] & b[0];
+  assign r0_3 = a[3] & b[0];
+  assign r0_4 = a[4] & b[0];
+  assign r0_5 = a[5] & b[0];
+  assign p[0] = r0_0;
+  and (pp1_0, a[0], b[1]);
+  xor (s1_0, pp1_0, r0_1);
+  and (c1_0, pp1_0, r0_1);
+  and (pp1_1, a[1], b[1]);
+  assign s1_1 = pp1_1 ^ r0_2 ^ c1_0;
+  assign c1_1 = pp1_1 & r0_2 | pp1_1 & c1_0 | r0_2 & c1_0;
+  and (pp1_2, a[2], b[1]);
+  assign s1_2 = pp1_2 ^ r0_3 ^ c1_1;
+  assign c1_2 = pp1_2 & r0_3 | pp1_2 & c1_1 | r0_3 & c1_1;
+  and (pp1_3, a[3], b[1]);
+  assign s1_3 = pp1_3 ^ r0_4 ^ c1_2;
+  assign c1_3 = pp1_3 & r0_4 | pp1_3 & c1_2 | r0_4 & c1_2;
+  and (pp1_4, a[4], b[1]);
+  assign s1_4 = pp1_4 ^ r0_5 ^ c1_3;
+  assign c1_4 = pp1_4 & r0_5 | pp1_4 & c1_3 | r0_5 & c1_3;
+  and (pp1_5, a[5], b[1]);
+  assign s1_5 = pp1_5 ^ 1'b0 ^ c1_4;
+  assign c1_5 = pp1_5 & 1'b0 | pp1_5 & c1_4 | 1'b0 & c1_4;
+  assign p[1] = s1_0;
+  and (pp2_0, a[0], b[2]);
+  xor (s2_0, pp2_0, s1_1);
+  and (c2_0, pp2_0, s1_1);
+  and (pp2_1, a[1], b[2]);
+  assign s2_1 = pp2_1 ^ s1_2 ^ c2_0;
+  assign c2_1 = pp2_1 & s1_2 | pp2_1 & c2_0 | s1_2 & c2_0;
+  and (pp2_2, a[2], b[2]);
+  assign s2_2 = pp2_2 ^ s1_3 ^ c2_1;
+  assign c2_2 = pp2_2 & s1_3 | pp2_2 & c2_1 | s1_3 & c2_1;
+  and (pp2_3, a[3], b[2]);
+  assign s2_3 = pp2_3 ^ s1_4 ^ c2_2;
+  assign c2_3 = pp2_3 & s1_4 | pp2_3 & c2_2 | s1_4 & c2_2;
+  and (pp2_4, a[4], b[2]);
+  assign s2_4 = pp2_4 ^ s1_5 ^ c2_3;
+  assign c2_4 = pp2_4 & s1_5 | pp2_4 & c2_3 | s1_5 & c2_3;
+  and (pp2_5, a[5], b[2]);
+  assign s2_5 = pp2_5 ^ c1_5 ^ c2_4;
+  assign c2_5 = pp2_5 & c1_5 | pp2_5 & c2_4 | c1_5 & c2_4;
+  assign p[2] = s2_0;
+  and (pp3_0, a[0], b[3]);
+  xor (s3_0, pp3_0, s2_1);
+  and (c3_0, pp3_0, s2_1);
+  and (pp3_1, a[1], b[3]);
+  assign s3_1 = pp3_1 ^ s2_2 ^ c3_0;
+  assign c3_1 = pp3_1 & s2_2 | pp3_1 & c3_0 | s2_2 & c3_0;
+  and (pp3_2, a[2], b[3]);
+  assign s3_2 = pp3_2 ^ s2_3 ^ c3_1;
+  assign c3_2 = pp3_2 & s2_3 | pp3_2 & c3_1 | s2_3 & c3_1;
+  and (pp3_3, a[3], b[3]);
+  assign s3_3 = pp3_3 ^ s2_4 ^ c3_2;
+  assign c3_3 = pp3_3 & s2_4 | pp3_3 & c3_2 | s2_4 & c3_2;
+  and (pp3_4, a[4], b[3]);
+  assign s3_4 = pp3_4 ^ s2_5 ^ c3_3;
+  assign c3_4 = pp3_4 & s2_5 | pp3_4 & c3_3 | s2_5 & c3_3;
+  and (pp3_5, a[5], b[3]);
+  assign s3_5 = pp3_5 ^ c2_5 ^ c3_4;
+  assign c3_5 = pp3_5 & c2_5 | pp3_5 & c3_4 | c2_5 & c3_4;
+  assign p[3] = s3_0;
+  and (pp4_0, a[0], b[4]);
+  xor (s4_0, pp4_0, s3_1);
+  and (c4_0, pp4_0, s3_1);
+  and (pp4_1, a[1], b[4]);
+  assign s4_1 = pp4_1 ^ s3_2 ^ c4_0;
+  assign c4_1 = pp4_1 & s3_2 | pp4_1 & c4_0 | s3_2 & c4_0;
+  and (pp4_2, a[2], b[4]);
+  assign s4_2 = pp4_2 ^ s3_3 ^ c4_1;
+  assign c4_2 = pp4_2 & s3_3 | pp4_2 & c4_1 | s3_3 & c4_1;
+  and (pp4_3, a[3], b[4]);
+  assign s4_3 = pp4_3 ^ s3_4 ^ c4_2;
+  assign c4_3 = pp4_3 & s3_4 | pp4_3 & c4_2 | s3_4 & c4_2;
+  and (pp4_4, a[4], b[4]);
+  assign s4_4 = pp4_4 ^ s3_5 ^ c4_3;
+  assign c4_4 = pp4_4 & s3_5 | pp4_4 & c4_3 | s3_5 & c4_3;
+  and (pp4_5, a[5], b[4]);
+  assign s4_5 = pp4_5 ^ c3_5 ^ c4_4;
+  assign c4_5 = pp4_5 & c3_5 | pp4_5 & c4_4 | c3_5 & c4_4;
+  assign p[4] = s4_0;
+  and (pp5_0, a[0], b[5]);
+  xor (s5_0, pp5_0, s4_1);
+  and (c5_0, pp5_0, s4_1);
+  and (pp5_1, a[1], b[5]);
+  assign s5_1 = pp5_1 ^ s4_2 ^ c5_0;
+  assign c5_1 = pp5_1 & s4_2 | pp5_1 & c5_0 | s4_2 & c5_0;
+  and (pp5_2, a[2], b[5]);
+  assign s5_2 = pp5_2 ^ s4_3 ^ c5_1;
+  assign c5_2 = pp5_2 & s4_3 | pp5_2 & c5_1 | s4_3 & c5_1;
+  and (pp5_3, a[3], b[5]);
+  assign s5_3 = pp5_3 ^ s4_4 ^ c5_2;
+  assign c5_3 = pp5_3 & s4_4 | pp5_3 & c5_2 | s4_4 & c5_2;
+  and (pp5_4, a[4], b[5]);
+  assign s5_4 = pp5_4 ^ s4_5 ^ c5_3;
+  assign c5_4 = pp5_4 & s4_5 | pp5_4 & c5_3 | s4_5 & c5_3;
+  and (pp5_5, a[5], b[5]);
+  assign s5_5 = pp5_5 ^ c4_5 ^ c5_4;
+  assign c5_5 = pp5_5 & c4_5 | pp5_5 & c5_4 | c4_5 & c5_4;
+  assign p[5] = s5_0;
+  assign p[6] = s5_1;
+  assign p[7] = s5_2;
+  assign p[8] = s5_3;
+  assign p[9] = s5_4;
+  assign p[10] = s5_5;
+  assign p[11] = c5_5;
+endmodule
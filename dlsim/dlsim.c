@@ -0,0 +1,2509 @@
+#define _POSIX_C_SOURCE 200809L
+#include<stdlib.h>
+#include<stdio.h>
+#include<string.h>
+#include<errno.h>
+#include<stdbool.h>
+#include<stdatomic.h>
+#include<pthread.h>
+#include<math.h>
+#include<time.h>
+#include<unistd.h>
+#include<sys/stat.h>
+#include<sys/mman.h>
+#include<sys/socket.h>
+#include<sys/un.h>
+#include<sys/time.h>
+#include<poll.h>
+#include<signal.h>
+#include<fcntl.h>
+#include "../libdls/dls.h"
+
+/*
+ * dlsim: truth table driver for libdls
+ *
+ * Prints the same table as second: one row per input combination in gray code order,
+ * the input values followed by the output values
+ *
+ * usage: dlsim [options] <circuit> [stimulus | circuit...]
+ * One mode and one table engine at most; options the chosen mode does not read are rejected
+ *	--cycles N	Run N clock cycles from the stimulus file (- for stdin) instead of the table
+ *	--streams K	Number of independent stimulus streams, 1 to 64
+ *	--flatten	Expand module instances instead of sharing their templates
+ *	--faults	Grade the vectors of --vectors, or the full sweep, against all stuck-at faults
+ *	--activity	Count the rising and falling transitions of every net over --vectors or the sweep
+ *	--timing	Apply every transition of the sweep with gate delays and report the settle
+ *			time, transitions and glitches of each output
+ *	--delays F	Delays for --timing, lines of "TYPE delay" for a gate type or "net delay"
+ *			for the gate driving net; every gate takes 1 otherwise
+ *	--analyze	Report the gate types, levels, fanout, output and input cones and longest path as JSON
+ *	--serve PATH	Load every circuit named once, then answer batches of vectors sent to the Unix
+ *			socket PATH from --threads workers until SIGINT or SIGTERM; see struct request
+ *	--monte-carlo N	Estimate the probability of each output being 1 from N random vectors
+ *	--seed S	Seed of the random vectors of --monte-carlo, 0 by default
+ *	--dump F	Also write the rows of the random vectors of --monte-carlo to F, on one thread
+ *	--format F	Report format of --activity, --timing and --monte-carlo, csv or json
+ *	--vectors F	Vector file for --faults and --activity, one row of input values per vector
+ *	--threads T	Worker threads of --level-parallel, --work-stealing, --cofactor, -o, --faults,
+ *			--monte-carlo without --dump and --serve, 0 for one per processor
+ *	--level-parallel	Split each level of the table's gates among the --threads threads
+ *	--work-stealing	Build the table from output cone and vector block tasks run by --threads threads;
+ *			with --vectors, the table lists those vectors instead of the sweep
+ *	--ternary	Simulate 0, 1 and X: the table lists the --vectors rows, which may hold X,
+ *			and --cycles reads X from the stimulus and starts the flip-flops at X
+ *	--threaded	Evaluate the table with direct-threaded code instead of the gate switch
+ *	--cofactor	Split the table into cofactors of the first inputs, chosen from the gates saved, and
+ *			sweep each with the gates left after constant propagation, on --threads threads
+ *	--cofactor-bits K	Like --cofactor with the first K inputs fixed
+ *	--support	Sweep each group of outputs with the same input support over its own inputs only,
+ *			then read the table rows from the groups
+ *	--support-tables	Print the table of each support group over its own inputs instead of the full table
+ *	--tiled	Build the table tile by tile, each tile of gates sized to stay in L2 for a block of words;
+ *		with --vectors, the table lists those vectors instead of the sweep
+ *	-o F, --output F	Write the table to F, formatted by --threads threads straight into a mapping
+ *			of the file, instead of printing it
+ *	--range S:E	Print only rows S to E-1 of the table, E omitted for the last row
+ *	--shard K/N	Print only the K-th of N equal parts of the rows, counting from 0;
+ *			the outputs of shards 0 to N-1 concatenate into the full table
+ *	--gray-order O	Order of the sweep's gray code bits: inputs, the first input changing least often,
+ *			or fanout, the inputs with the smallest fanout cones changing most often
+ *	--checkpoint F	Record the rows printed so far in F every few seconds, and resume from F
+ *			if it exists; resume with the output appended (>>) to the same file
+ *	--stats	Print the per-thread task, steal and utilization counters of --work-stealing,
+ *		the tile sizes of --tiled, the instruction counts of --threaded, the split of --cofactor,
+ *		the support groups of --support, the events of --timing, or the latency of each --serve
+ *		worker to stderr; for the plain table,
+ *		how long evaluation and the writer thread waited on each other
+ */
+
+/*What dlsim runs*/
+#define MODE_TABLE 0
+#define MODE_CYCLES 1
+#define MODE_FAULTS 2
+#define MODE_ACTIVITY 3
+#define MODE_MONTECARLO 4
+#define MODE_TIMING 5
+#define MODE_SUPPORT 6
+#define MODE_ANALYZE 7
+#define MODE_SERVE 8
+
+/*Normal quantile of the 95% confidence intervals*/
+#define CONFIDENCE_Z 1.96
+
+/*
+ * Structure: options
+ *
+ * Parsed command line
+ *
+ * threads_set, seed_set, format_set: Whether --threads, --seed and --format were given,
+ *	so that modes that do not read them can reject them
+ *
+ */
+struct options {
+	int mode;
+	const char* circuit;
+	const char* stimulus;
+	long cycles;
+	int streams;
+	bool flatten;
+	const char* vectors;
+	int threads;
+	bool json;
+	bool level_parallel;
+	bool work_stealing;
+	bool tiled;
+	bool threaded;
+	bool support;
+	int cofactor_bits;
+	bool ternary;
+	bool stats;
+	uint64_t range_start;
+	uint64_t range_end;
+	int shard;
+	int shards;
+	const char* checkpoint;
+	uint64_t samples;
+	uint64_t seed;
+	const char* dump;
+	const char* delays;
+	const char* output;
+	bool fanout_order;
+	const char* socket;
+	char** paths;
+	int num_paths;
+	bool bad;
+	bool threads_set;
+	bool seed_set;
+	bool format_set;
+};
+
+/*Cycles read from the stimulus and simulated per batch*/
+#define CYCLE_BATCH 4096
+
+/*Seconds between checkpoints of a table*/
+#define CHECKPOINT_SECONDS 10
+
+/*FNV-1a, which identifies the circuit of a checkpoint*/
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+/*Blocks of 64 rows a thread of --output claims at a time*/
+#define MAP_CHUNK 256
+
+/*Buffers in the ring between the evaluation of a table and its writer*/
+#define RING_SLOTS 8
+
+/*Blocks of 64 rows per ring buffer*/
+#define RING_BLOCKS 1024
+
+/*Polls of the ring before a waiting stage sleeps for RING_NAP_NS*/
+#define SPIN_LIMIT 256
+#define RING_NAP_NS 20000
+
+/*Vectors one --serve request may carry; clients split larger batches*/
+#define SERVE_MAX_VECTORS 65536
+
+/*Milliseconds a --serve connection may stay idle between requests before it is dropped*/
+#define SERVE_IDLE_MS 5000
+
+/*Milliseconds a client may take to send the rest of a request, or to take in its reply*/
+#define SERVE_IO_MS 1000
+
+/*
+ * Structure: sweep
+ *
+ * The rows of a table one run prints, and its checkpoint
+ *
+ * start, end: The run prints rows start to end-1
+ *
+ * next: First row not printed yet
+ *
+ * row_bytes: Length of a printed row, to find where the output of a row starts
+ *
+ * base: Offset where the rows start in the output file, which may hold a header before them
+ *
+ * identity: Hash of the circuit, the --vectors file and the sweep order, so that a
+ *	checkpoint only resumes the run that saved it
+ *
+ * device, inode: The output file, or 0 when the output is not a regular file
+ *
+ * saved: When the checkpoint was last written
+ *
+ */
+struct sweep {
+	uint64_t start;
+	uint64_t end;
+	uint64_t next;
+	int row_bytes;
+	uint64_t base;
+	uint64_t identity;
+	unsigned long long device;
+	unsigned long long inode;
+	const char* checkpoint;
+	time_t saved;
+	bool failed;
+};
+
+/*
+ * Function: formatRows
+ *
+ * Formats the evaluated rows of lanes from to to-1, 2*(num_inputs+num_outputs) bytes each
+ *
+ * returns: The end of the formatted rows
+ */
+static char* formatRows(int num_inputs, int num_outputs, int from, int to, const uint64_t* inwords, const uint64_t* outwords, char* p) {
+	for(int k = from; k < to; k++) {
+		for(int j = 0; j < num_inputs; j++) {
+			*p++ = '0' + ((inwords[j] >> k) & 1);
+			*p++ = ' ';
+		}
+		for(int o = 0; o < num_outputs; o++) {
+			*p++ = '0' + ((outwords[o] >> k) & 1);
+			*p++ = ' ';
+		}
+		p[-1] = '\n';
+	}
+	return p;
+}
+
+/*
+ * Function: printRows
+ *
+ * Formats the evaluated rows of lanes from to to-1 into a buffer and writes them out
+ *
+ * buf: Buffer of at least 2*(num_inputs+num_outputs)*lanes bytes
+ *
+ */
+static void printRows(int num_inputs, int num_outputs, int from, int to, const uint64_t* inwords, const uint64_t* outwords, char* buf) {
+	char* p = formatRows(num_inputs, num_outputs, from, to, inwords, outwords, buf);
+	fwrite(buf, 1, p - buf, stdout);
+}
+
+/*
+ * Function: hashBytes
+ *
+ * returns: The FNV-1a hash h extended with len bytes
+ */
+static uint64_t hashBytes(uint64_t h, const unsigned char* p, size_t len) {
+	for(size_t i = 0; i < len; i++) {
+		h = (h ^ p[i])*FNV_PRIME;
+	}
+	return h;
+}
+
+/*
+ * Function: hashFile
+ *
+ * Extends the FNV-1a hash h with the contents of a file
+ *
+ * returns: False if the file cannot be read
+ */
+static bool hashFile(const char* path, uint64_t* h) {
+	FILE* f = fopen(path, "rb");
+	if(f == NULL) {
+		return false;
+	}
+	unsigned char buf[16384];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		*h = hashBytes(*h, buf, n);
+	}
+	bool ok = !ferror(f);
+	fclose(f);
+	return ok;
+}
+
+/*
+ * Function: saveCheckpoint
+ *
+ * Flushes the rows printed so far and records the next row in the checkpoint file
+ * The file is replaced by renaming, so an interrupted save leaves the previous one
+ *
+ */
+static void saveCheckpoint(struct sweep* sw) {
+	struct stat st;
+	if(fflush(stdout) != 0 || (fstat(fileno(stdout), &st) == 0 && S_ISREG(st.st_mode) && fsync(fileno(stdout)) != 0)) {
+		perror("stdout");
+		sw->failed = true;
+		return;
+	}
+	size_t len = strlen(sw->checkpoint);
+	char* tmp = malloc(len + 5);
+	if(tmp == NULL) {
+		sw->failed = true;
+		return;
+	}
+	memcpy(tmp, sw->checkpoint, len);
+	strcpy(tmp + len, ".tmp");
+	FILE* f = fopen(tmp, "w");
+	bool ok = (f != NULL);
+	if(ok) {
+		fprintf(f, "%llu %llu %llu %d %llu %016llx %llu %llu\n", (unsigned long long)sw->start, (unsigned long long)sw->end,
+				(unsigned long long)sw->next, sw->row_bytes, (unsigned long long)sw->base,
+				(unsigned long long)sw->identity, sw->device, sw->inode);
+		ok = (fflush(f) == 0 && fsync(fileno(f)) == 0);
+		ok = (fclose(f) == 0) && ok;
+	}
+	if(!ok || rename(tmp, sw->checkpoint) != 0) {
+		perror(sw->checkpoint);
+		sw->failed = true;
+	}
+	free(tmp);
+	sw->saved = time(NULL);
+}
+
+/*
+ * Function: openSweep
+ *
+ * Works out the rows to print from --range and --shard, then resumes from the
+ * checkpoint if there is one, truncating the output to the rows it records
+ * The checkpoint holds the range, where the rows start in the output file, which
+ * file that is, and what the circuit and vectors hash to; a resume that does not
+ * match all of them is refused rather than truncated
+ * Shards are cut on multiples of 64 rows
+ *
+ * rows: Number of rows of the whole table
+ *
+ * row_bytes: Length of a printed row
+ *
+ * returns: 0, or 1 after printing why the rows cannot be printed
+ */
+static int openSweep(const struct options* opt, uint64_t rows, int row_bytes, struct sweep* sw) {
+	uint64_t start = opt->range_start;
+	uint64_t end = (opt->range_end < rows) ? opt->range_end : rows;
+	if(start > end) {
+		fprintf(stderr, "%s: range starts at row %llu, after its end at row %llu\n", opt->circuit,
+				(unsigned long long)start, (unsigned long long)end);
+		return 1;
+	}
+	if(opt->shards > 1) {
+		uint64_t first = start/64;
+		uint64_t words = (end + 63)/64 - first;
+		uint64_t k = opt->shard;
+		uint64_t n = opt->shards;
+		uint64_t lo = (first + (words/n)*k + (words%n)*k/n)*64;
+		uint64_t hi = (first + (words/n)*(k + 1) + (words%n)*(k + 1)/n)*64;
+		start = (lo > start) ? lo : start;
+		end = (hi < end) ? hi : end;
+		if(start > end) {
+			start = end;
+		}
+	}
+	sw->start = start;
+	sw->end = end;
+	sw->next = start;
+	sw->row_bytes = row_bytes;
+	sw->checkpoint = opt->checkpoint;
+	sw->saved = time(NULL);
+	sw->failed = false;
+	if(sw->checkpoint == NULL) {
+		return 0;
+	}
+	struct stat st;
+	bool regular = (fstat(fileno(stdout), &st) == 0 && S_ISREG(st.st_mode));
+	sw->base = regular ? (uint64_t)st.st_size : 0;
+	sw->device = regular ? (unsigned long long)st.st_dev : 0;
+	sw->inode = regular ? (unsigned long long)st.st_ino : 0;
+	sw->identity = FNV_OFFSET;
+	unsigned char order = opt->fanout_order;
+	if(!hashFile(opt->circuit, &sw->identity) || (opt->vectors != NULL && !hashFile(opt->vectors, &sw->identity))) {
+		perror((opt->vectors != NULL) ? opt->vectors : opt->circuit);
+		return 1;
+	}
+	sw->identity = hashBytes(sw->identity, &order, 1);
+	FILE* f = fopen(sw->checkpoint, "r");
+	if(f == NULL) {
+		return 0;
+	}
+	unsigned long long cstart, cend, cnext, cbase, cidentity, cdevice, cinode;
+	int cbytes;
+	int fields = fscanf(f, "%llu %llu %llu %d %llu %llx %llu %llu", &cstart, &cend, &cnext, &cbytes, &cbase, &cidentity,
+			&cdevice, &cinode);
+	fclose(f);
+	if(fields != 8 || cstart != start || cend != end || cbytes != row_bytes || cnext < cstart || cnext > cend || cidentity != sw->identity) {
+		fprintf(stderr, "%s: checkpoint is not for rows %llu:%llu of this circuit\n", sw->checkpoint,
+				(unsigned long long)start, (unsigned long long)end);
+		return 1;
+	}
+	sw->next = cnext;
+	sw->base = cbase;
+	if(regular) {
+		off_t printed = (off_t)(cbase + (cnext - cstart)*(uint64_t)row_bytes);
+		if(cdevice != sw->device || cinode != sw->inode || st.st_size < printed) {
+			fprintf(stderr, "%s: output is not the file the checkpoint was saved for, append to the same file\n",
+					sw->checkpoint);
+			return 1;
+		}
+		if(ftruncate(fileno(stdout), printed) != 0 || fseeko(stdout, 0, SEEK_END) != 0) {
+			perror("stdout");
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Function: advanceSweep
+ *
+ * Notes that the rows before next are printed, saving a checkpoint when one is due
+ *
+ */
+static void advanceSweep(struct sweep* sw, uint64_t next) {
+	sw->next = next;
+	if(sw->checkpoint != NULL && !sw->failed && time(NULL) - sw->saved >= CHECKPOINT_SECONDS) {
+		saveCheckpoint(sw);
+	}
+}
+
+/*
+ * Function: closeSweep
+ *
+ * Saves the final checkpoint, which makes running again print nothing
+ *
+ * returns: 0, or 1 if a checkpoint could not be saved
+ */
+static int closeSweep(struct sweep* sw) {
+	if(sw->checkpoint != NULL && !sw->failed) {
+		saveCheckpoint(sw);
+	}
+	return sw->failed;
+}
+
+/*
+ * Structure: ringslot
+ *
+ * One buffer of the output ring, blocks of 64 rows as packed words
+ *
+ * from, to: The lanes of each block to print
+ *
+ * words: The input words and then the output words of each block
+ *
+ */
+struct ringslot {
+	int blocks;
+	uint64_t* base;
+	int* from;
+	int* to;
+	uint64_t* words;
+};
+
+/*
+ * Structure: ring
+ *
+ * Lock-free single-producer single-consumer ring of buffers, from the evaluation
+ * of a table to the thread that formats and writes its rows
+ *
+ * head, tail: Buffers filled by the evaluation and emptied by the writer so far
+ *
+ * full_wait, empty_wait: Seconds the evaluation waited for an empty buffer and the
+ *	writer for a full one
+ *
+ */
+struct ring {
+	struct ringslot slots[RING_SLOTS];
+	atomic_size_t head;
+	atomic_size_t tail;
+	atomic_bool done;
+	int num_inputs;
+	int num_outputs;
+	struct sweep* sweep;
+	char* buf;
+	double full_wait;
+	double empty_wait;
+	pthread_t writer;
+};
+
+/*
+ * Function: seconds
+ *
+ * returns: The monotonic clock in seconds
+ */
+static double seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/*
+ * Function: ringPause
+ *
+ * Backs off while waiting on the other stage, spinning first and then sleeping
+ *
+ */
+static void ringPause(int* spins) {
+	if(++*spins > SPIN_LIMIT) {
+		struct timespec nap = {0, RING_NAP_NS};
+		nanosleep(&nap, NULL);
+	}
+}
+
+/*
+ * Function: ringWriter
+ *
+ * Writer thread: prints the rows of every filled buffer and advances the sweep
+ *
+ */
+static void* ringWriter(void* arg) {
+	struct ring* r = arg;
+	int words = r->num_inputs + r->num_outputs;
+	for(size_t t = 0;; t++) {
+		if(atomic_load(&r->head) == t) {
+			double begin = seconds();
+			int spins = 0;
+			while(atomic_load(&r->head) == t && !atomic_load(&r->done)) {
+				ringPause(&spins);
+			}
+			r->empty_wait += seconds() - begin;
+			if(atomic_load(&r->head) == t) { //Done, and the last buffer was published before that
+				return NULL;
+			}
+		}
+		const struct ringslot* slot = &r->slots[t % RING_SLOTS];
+		for(int b = 0; b < slot->blocks; b++) {
+			const uint64_t* w = &slot->words[(size_t)b*words];
+			printRows(r->num_inputs, r->num_outputs, slot->from[b], slot->to[b], w, w + r->num_inputs, r->buf);
+			advanceSweep(r->sweep, slot->base[b] + slot->to[b]);
+		}
+		atomic_store(&r->tail, t + 1);
+	}
+}
+
+/*
+ * Function: ringClose
+ *
+ * Publishes a partly filled buffer, waits for the writer and frees the ring
+ *
+ */
+static void ringClose(struct ring* r, struct ringslot* slot) {
+	if(slot != NULL && slot->blocks > 0) {
+		atomic_fetch_add(&r->head, 1);
+	}
+	atomic_store(&r->done, true);
+	pthread_join(r->writer, NULL);
+	for(int i = 0; i < RING_SLOTS; i++) {
+		free(r->slots[i].base);
+		free(r->slots[i].from);
+		free(r->slots[i].to);
+		free(r->slots[i].words);
+	}
+	free(r->buf);
+}
+
+/*
+ * Function: ringOpen
+ *
+ * Allocates the ring of a table and starts its writer thread
+ *
+ * returns: 0, or 1 if out of memory
+ */
+static int ringOpen(struct ring* r, int num_inputs, int num_outputs, struct sweep* sw) {
+	memset(r, 0, sizeof(struct ring));
+	atomic_init(&r->head, 0);
+	atomic_init(&r->tail, 0);
+	atomic_init(&r->done, false);
+	r->num_inputs = num_inputs;
+	r->num_outputs = num_outputs;
+	r->sweep = sw;
+	r->buf = malloc(2*(num_inputs + num_outputs)*64);
+	bool ok = (r->buf != NULL);
+	for(int i = 0; i < RING_SLOTS; i++) {
+		r->slots[i].base = malloc(RING_BLOCKS*sizeof(uint64_t));
+		r->slots[i].from = malloc(RING_BLOCKS*sizeof(int));
+		r->slots[i].to = malloc(RING_BLOCKS*sizeof(int));
+		r->slots[i].words = malloc((size_t)RING_BLOCKS*(num_inputs + num_outputs)*sizeof(uint64_t));
+		ok = ok && r->slots[i].base != NULL && r->slots[i].from != NULL && r->slots[i].to != NULL && r->slots[i].words != NULL;
+	}
+	if(!ok || pthread_create(&r->writer, NULL, ringWriter, r) != 0) {
+		for(int i = 0; i < RING_SLOTS; i++) {
+			free(r->slots[i].base);
+			free(r->slots[i].from);
+			free(r->slots[i].to);
+			free(r->slots[i].words);
+		}
+		free(r->buf);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Function: ringAcquire
+ *
+ * Waits for an empty buffer for the evaluation to fill
+ *
+ */
+static struct ringslot* ringAcquire(struct ring* r) {
+	size_t h = atomic_load(&r->head);
+	if(h - atomic_load(&r->tail) == RING_SLOTS) {
+		double begin = seconds();
+		int spins = 0;
+		while(h - atomic_load(&r->tail) == RING_SLOTS) {
+			ringPause(&spins);
+		}
+		r->full_wait += seconds() - begin;
+	}
+	struct ringslot* slot = &r->slots[h % RING_SLOTS];
+	slot->blocks = 0;
+	return slot;
+}
+
+/*
+ * Function: printSupportStats
+ *
+ * Prints the support groups and the rows swept for them to stderr
+ *
+ */
+static void printSupportStats(const struct dls_circuit* c, const struct dls_support* sup) {
+	int groups = dlsSupportNumGroups(sup);
+	for(int g = 0; g < groups; g++) {
+		const int* list;
+		int ni = dlsSupportGroupInputs(sup, g, &list);
+		int no = dlsSupportGroupOutputs(sup, g, &list);
+		fprintf(stderr, "group %d inputs %d outputs %d\n", g, ni, no);
+	}
+	int n = dlsNumInputs(c);
+	fprintf(stderr, "groups %d rows swept %llu of %s%llu\n", groups, (unsigned long long)dlsSupportSwept(sup),
+			n < 64 ? "" : "2^", n < 64 ? (unsigned long long)1 << n : (unsigned long long)n);
+}
+
+/*
+ * Function: canTabulate
+ *
+ * Checks that a table of the circuit can be printed, and says why not otherwise
+ *
+ * returns: False if there are no outputs or more than 63 inputs to enumerate
+ */
+static bool canTabulate(const struct options* opt, int num_inputs, int num_outputs) {
+	if(num_outputs == 0) {
+		fprintf(stderr, "%s: no outputs to tabulate\n", opt->circuit);
+		return false;
+	}
+	if(num_inputs > 63) {
+		fprintf(stderr, "%s: cannot enumerate %d inputs\n", opt->circuit, num_inputs);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Function: runTruthTable
+ *
+ * Prints the truth table of a combinational circuit, or the rows of it the sweep
+ * options select, flip-flops held at 0
+ *
+ * returns: The exit status
+ */
+static int runTruthTable(const struct dls_circuit* c, const struct options* opt) {
+	int num_inputs = dlsNumInputs(c);
+	int num_outputs = dlsNumOutputs(c);
+	if(!canTabulate(opt, num_inputs, num_outputs)) {
+		return 1;
+	}
+	struct sweep sw;
+	if(openSweep(opt, (uint64_t)1 << num_inputs, 2*(num_inputs + num_outputs), &sw) != 0) {
+		return 1;
+	}
+	struct dls_state* s = dlsStateNew(c);
+	struct dls_pool* pool = opt->level_parallel ? dlsPoolNew(c, opt->threads) : NULL;
+	struct dls_program* prog = opt->threaded ? dlsProgramNew(c) : NULL;
+	int rc = DLS_ERR_NOMEM;
+	struct dls_support* sup = opt->support ? dlsSupportNew(c, &rc) : NULL;
+	if(s == NULL || (opt->level_parallel && pool == NULL) || (opt->threaded && prog == NULL) || (opt->support && sup == NULL)) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+		dlsStateFree(s);
+		dlsPoolFree(pool);
+		dlsProgramFree(prog);
+		dlsSupportFree(sup);
+		return 1;
+	}
+	if(prog != NULL && opt->stats) {
+		fprintf(stderr, "gates %d instructions %d fused %d\n", dlsNumGates(c), dlsProgramNumInsns(prog), dlsProgramNumFused(prog));
+	}
+	if(sup != NULL && opt->stats) {
+		printSupportStats(c, sup);
+	}
+	struct ring ring;
+	bool ring_ok = (ringOpen(&ring, num_inputs, num_outputs, &sw) == 0);
+	if(!ring_ok) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(DLS_ERR_NOMEM));
+	}
+	struct ringslot* slot = NULL;
+	uint64_t first = sw.next;
+	for(uint64_t base = first & ~(uint64_t)63; ring_ok && base < sw.end; base += 64) {
+		if(slot == NULL) {
+			slot = ringAcquire(&ring);
+		}
+		int b = slot->blocks++;
+		uint64_t* words = &slot->words[(size_t)b*(num_inputs + num_outputs)];
+		slot->base[b] = base;
+		slot->from[b] = (first > base) ? (int)(first - base) : 0;
+		slot->to[b] = (sw.end - base < 64) ? (int)(sw.end - base) : 64;
+		dlsSetGrayInputs(s, base);
+		for(int j = 0; j < num_inputs; j++) {
+			words[j] = dlsGetInput(s, j);
+		}
+		if(sup != NULL) {
+			dlsSupportEval(sup, s);
+		}
+		else if(pool != NULL) {
+			dlsPoolEval(pool, s);
+		}
+		else if(prog != NULL) {
+			dlsProgramEval(prog, s);
+		}
+		else {
+			dlsEvalWords(c, s);
+		}
+		for(int o = 0; o < num_outputs; o++) {
+			words[num_inputs + o] = dlsGetOutput(s, o);
+		}
+		if(slot->blocks == RING_BLOCKS) {
+			atomic_fetch_add(&ring.head, 1);
+			slot = NULL;
+		}
+	}
+	if(ring_ok) {
+		ringClose(&ring, slot);
+		if(opt->stats) {
+			fprintf(stderr, "pipeline: evaluation waited %.3fs for the writer, writer waited %.3fs for evaluation, %s-bound\n",
+					ring.full_wait, ring.empty_wait, (ring.full_wait > ring.empty_wait) ? "I/O" : "compute");
+		}
+	}
+	dlsPoolFree(pool);
+	dlsProgramFree(prog);
+	dlsSupportFree(sup);
+	dlsStateFree(s);
+	return (!ring_ok) | closeSweep(&sw);
+}
+
+/*
+ * Structure: mapjob
+ *
+ * Shared by the threads of runMappedTable
+ *
+ * map: The output file, mapped; row r of the table is at (r - start)*row_bytes
+ *
+ * next: Next chunk of MAP_CHUNK blocks to claim
+ *
+ */
+struct mapjob {
+	const struct dls_circuit* circuit;
+	const struct dls_support* support;
+	char* map;
+	uint64_t start;
+	uint64_t end;
+	int row_bytes;
+	atomic_ullong next;
+	atomic_bool failed;
+};
+
+/*
+ * Function: mapWorker
+ *
+ * Claims chunks of rows, evaluates them and formats them into their place in the mapping
+ *
+ */
+static void* mapWorker(void* arg) {
+	struct mapjob* job = arg;
+	int ni = dlsNumInputs(job->circuit);
+	int no = dlsNumOutputs(job->circuit);
+	struct dls_state* s = dlsStateNew(job->circuit);
+	uint64_t* words = malloc((ni + no + 1)*sizeof(uint64_t));
+	if(s == NULL || words == NULL) {
+		atomic_store(&job->failed, true);
+		dlsStateFree(s);
+		free(words);
+		return NULL;
+	}
+	uint64_t first = job->start & ~(uint64_t)63;
+	for(;;) {
+		uint64_t chunk = first + atomic_fetch_add(&job->next, 1)*MAP_CHUNK*64;
+		if(chunk >= job->end) {
+			break;
+		}
+		for(uint64_t base = chunk; base < chunk + MAP_CHUNK*64 && base < job->end; base += 64) {
+			int from = (job->start > base) ? (int)(job->start - base) : 0;
+			int to = (job->end - base < 64) ? (int)(job->end - base) : 64;
+			dlsSetGrayInputs(s, base);
+			for(int j = 0; j < ni; j++) {
+				words[j] = dlsGetInput(s, j);
+			}
+			if(job->support != NULL) {
+				dlsSupportEval(job->support, s);
+			}
+			else {
+				dlsEvalWords(job->circuit, s);
+			}
+			for(int o = 0; o < no; o++) {
+				words[ni + o] = dlsGetOutput(s, o);
+			}
+			formatRows(ni, no, from, to, words, words + ni, job->map + (base + from - job->start)*job->row_bytes);
+		}
+	}
+	dlsStateFree(s);
+	free(words);
+	return NULL;
+}
+
+/*
+ * Function: runMappedTable
+ *
+ * Writes the truth table, or the rows of it the sweep options select, to the --output
+ * file. Every row is as long as any other, so the file is sized up front and mapped,
+ * and each thread formats the chunks of rows it claims directly into their place
+ *
+ * returns: The exit status
+ */
+static int runMappedTable(const struct dls_circuit* c, const struct options* opt) {
+	int num_inputs = dlsNumInputs(c);
+	int num_outputs = dlsNumOutputs(c);
+	if(!canTabulate(opt, num_inputs, num_outputs)) {
+		return 1;
+	}
+	struct mapjob job;
+	memset(&job, 0, sizeof(job));
+	struct sweep sw;
+	job.row_bytes = 2*(num_inputs + num_outputs);
+	if(openSweep(opt, (uint64_t)1 << num_inputs, job.row_bytes, &sw) != 0) {
+		return 1;
+	}
+	job.circuit = c;
+	job.start = sw.start;
+	job.end = sw.end;
+	atomic_init(&job.next, 0);
+	atomic_init(&job.failed, false);
+	uint64_t size = (sw.end - sw.start)*(uint64_t)job.row_bytes;
+	int fd = open(opt->output, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if(fd < 0) {
+		perror(opt->output);
+		return 1;
+	}
+	int err = (ftruncate(fd, (off_t)size) != 0) ? errno : (size > 0) ? posix_fallocate(fd, 0, (off_t)size) : 0;
+	if(err == 0 && size > 0) {
+		job.map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		err = (job.map == MAP_FAILED) ? errno : 0;
+	}
+	if(err != 0) {
+		fprintf(stderr, "%s: %s\n", opt->output, strerror(err));
+		close(fd);
+		return 1;
+	}
+	int rc = DLS_ERR_NOMEM;
+	struct dls_support* sup = opt->support ? dlsSupportNew(c, &rc) : NULL;
+	job.support = sup;
+	int threads = dlsSchedThreads(opt->threads);
+	pthread_t* tids = malloc(threads*sizeof(pthread_t));
+	double begin = seconds();
+	int started = 0;
+	for(int t = 1; size > 0 && tids != NULL && (sup != NULL || !opt->support) && t < threads; t++) {
+		if(pthread_create(&tids[t], NULL, mapWorker, &job) != 0) {
+			break;
+		}
+		started++;
+	}
+	if(size > 0 && tids != NULL && (sup != NULL || !opt->support)) {
+		mapWorker(&job);
+	}
+	else if(size > 0) {
+		atomic_store(&job.failed, true);
+	}
+	for(int t = 1; t <= started; t++) {
+		pthread_join(tids[t], NULL);
+	}
+	double elapsed = seconds() - begin;
+	bool failed = atomic_load(&job.failed);
+	if(failed) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+	}
+	if((size > 0 && munmap(job.map, size) != 0) || close(fd) != 0) {
+		perror(opt->output);
+		failed = true;
+	}
+	if(!failed && opt->stats) {
+		fprintf(stderr, "threads %d rows %llu bytes %llu in %.3fs, %.1f MB/s\n", started + 1, (unsigned long long)(sw.end - sw.start),
+				(unsigned long long)size, elapsed, (elapsed > 0) ? size/elapsed/1e6 : 0);
+	}
+	dlsSupportFree(sup);
+	free(tids);
+	return failed;
+}
+
+/*
+ * Function: runSupportTables
+ *
+ * Prints the table of every support group over its own inputs, in gray code order,
+ * each headed by the INPUTVAR and OUTPUTVAR lines of the group and followed by a blank line
+ *
+ * returns: The exit status
+ */
+static int runSupportTables(const struct dls_circuit* c, const struct options* opt) {
+	int rc;
+	struct dls_support* sup = dlsSupportNew(c, &rc);
+	if(sup == NULL) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+		return 1;
+	}
+	if(opt->stats) {
+		printSupportStats(c, sup);
+	}
+	for(int g = 0; g < dlsSupportNumGroups(sup); g++) {
+		const int* inputs;
+		const int* outputs;
+		int ni = dlsSupportGroupInputs(sup, g, &inputs);
+		int no = dlsSupportGroupOutputs(sup, g, &outputs);
+		printf("INPUTVAR %d", ni);
+		for(int i = 0; i < ni; i++) {
+			printf(" %s", dlsInputName(c, inputs[i]));
+		}
+		printf("\nOUTPUTVAR %d", no);
+		for(int o = 0; o < no; o++) {
+			printf(" %s", dlsOutputName(c, outputs[o]));
+		}
+		putchar('\n');
+		for(uint64_t r = 0; r < (uint64_t)1 << ni; r++) {
+			uint64_t index = r ^ (r >> 1);
+			for(int i = 0; i < ni; i++) {
+				putchar('0' + (int)((index >> (ni - 1 - i)) & 1));
+				putchar(' ');
+			}
+			for(int o = 0; o < no; o++) {
+				putchar('0' + dlsSupportLookup(sup, outputs[o], index));
+				putchar(o == no - 1 ? '\n' : ' ');
+			}
+		}
+		putchar('\n');
+	}
+	dlsSupportFree(sup);
+	if(fflush(stdout) != 0) {
+		perror("stdout");
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Function: readStimulus
+ *
+ * Reads cycles from the stimulus file and packs them into input words
+ * A cycle is num_inputs values for stream 0, then stream 1, and so on;
+ * characters other than 0 and 1, and X when unknown is given, are separators
+ *
+ * in: Filled with cycles*num_inputs words
+ *
+ * unknown: Filled the same way with the X bits, NULL if the stimulus has no X
+ *
+ * returns: The number of complete cycles read
+ */
+static long readStimulus(FILE* stim, int num_inputs, int streams, long cycles, uint64_t* in, uint64_t* unknown) {
+	memset(in, 0, cycles*num_inputs*sizeof(uint64_t));
+	if(unknown != NULL) {
+		memset(unknown, 0, cycles*num_inputs*sizeof(uint64_t));
+	}
+	long total = (long)num_inputs*streams;
+	for(long k = 0; k < cycles; k++) {
+		for(long b = 0; b < total; b++) {
+			int ch;
+			while((ch = getc(stim)) != EOF && ch != '0' && ch != '1' && (unknown == NULL || (ch != 'X' && ch != 'x')));
+			if(ch == EOF) {
+				return k;
+			}
+			if(ch == 'X' || ch == 'x') {
+				unknown[k*num_inputs + b % num_inputs] |= (uint64_t)1 << (b / num_inputs);
+			}
+			else {
+				in[k*num_inputs + b % num_inputs] |= (uint64_t)(ch - '0') << (b / num_inputs);
+			}
+		}
+	}
+	return cycles;
+}
+
+/*
+ * Function: runTernaryCycles
+ *
+ * Evaluates and clocks one batch of cycles in three-valued logic
+ *
+ * in, unknown: The input words read by readStimulus
+ *
+ * out, xout: Filled with the output words and their X bits, cycles*num_outputs words each
+ *
+ */
+static void runTernaryCycles(const struct dls_circuit* c, struct dls_xstate* s, long cycles, const uint64_t* in, const uint64_t* unknown, uint64_t* out, uint64_t* xout) {
+	int ni = dlsNumInputs(c);
+	int no = dlsNumOutputs(c);
+	for(long k = 0; k < cycles; k++) {
+		for(int i = 0; i < ni; i++) {
+			dlsXSetInput(s, i, in[k*ni + i], unknown[k*ni + i]);
+		}
+		dlsXEvalWords(c, s);
+		for(int o = 0; o < no; o++) {
+			dlsXGetOutput(s, o, &out[k*no + o], &xout[k*no + o]);
+		}
+		dlsXClock(c, s);
+	}
+}
+
+/*
+ * Function: runCycles
+ *
+ * Clocks a sequential circuit from a stimulus file, all streams at once,
+ * and prints the outputs of every stream for every cycle, one cycle per line
+ *
+ * returns: The exit status
+ */
+static int runCycles(const struct dls_circuit* c, const struct options* opt) {
+	int num_inputs = dlsNumInputs(c);
+	int num_outputs = dlsNumOutputs(c);
+	FILE* stim = stdin;
+	if(strcmp(opt->stimulus, "-") != 0) {
+		stim = fopen(opt->stimulus, "r");
+		if(stim == NULL) {
+			fprintf(stderr, "%s: %s\n", opt->stimulus, dlsErrorString(DLS_ERR_IO));
+			return 1;
+		}
+	}
+	struct dls_state* s = NULL;
+	struct dls_xstate* xs = NULL;
+	uint64_t* unknown = NULL;
+	uint64_t* xout = NULL;
+	if(opt->ternary) {
+		xs = dlsXStateNew(c);
+		unknown = malloc(((long)CYCLE_BATCH*num_inputs + 1)*sizeof(uint64_t));
+		xout = calloc((long)CYCLE_BATCH*num_outputs + 1, sizeof(uint64_t));
+	}
+	else {
+		s = dlsStateNew(c);
+	}
+	uint64_t* in = malloc(((long)CYCLE_BATCH*num_inputs + 1)*sizeof(uint64_t));
+	uint64_t* out = malloc(((long)CYCLE_BATCH*num_outputs + 1)*sizeof(uint64_t));
+	char* buf = malloc(2*num_outputs*opt->streams + 1);
+	int ret = 0;
+	if((s == NULL && xs == NULL) || (opt->ternary && (unknown == NULL || xout == NULL)) || in == NULL || out == NULL || buf == NULL) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(DLS_ERR_NOMEM));
+		ret = 1;
+	}
+	for(long done = 0; ret == 0 && done < opt->cycles; ) {
+		long want = (opt->cycles - done < CYCLE_BATCH) ? opt->cycles - done : CYCLE_BATCH;
+		long got = readStimulus(stim, num_inputs, opt->streams, want, in, unknown);
+		if(opt->ternary) {
+			runTernaryCycles(c, xs, got, in, unknown, out, xout);
+		}
+		else {
+			dlsRunCycles(c, s, got, in, out);
+		}
+		for(long k = 0; k < got; k++) {
+			char* p = buf;
+			for(int lane = 0; lane < opt->streams; lane++) {
+				for(int o = 0; o < num_outputs; o++) {
+					bool x = (xout != NULL) && ((xout[k*num_outputs + o] >> lane) & 1);
+					*p++ = x ? 'X' : '0' + ((out[k*num_outputs + o] >> lane) & 1);
+					*p++ = ' ';
+				}
+			}
+			if(p == buf) {
+				*p++ = ' ';
+			}
+			p[-1] = '\n';
+			fwrite(buf, 1, p - buf, stdout);
+		}
+		done += got;
+		if(got < want) {
+			fprintf(stderr, "%s: stimulus ends after %ld cycles\n", opt->stimulus, done);
+			ret = 1;
+		}
+	}
+	if(stim != stdin) {
+		fclose(stim);
+	}
+	free(buf);
+	free(in);
+	free(out);
+	free(unknown);
+	free(xout);
+	dlsStateFree(s);
+	dlsXStateFree(xs);
+	return ret;
+}
+
+/*
+ * Function: readVectorFile
+ *
+ * Reads a file of input vectors, num_inputs values of 0 or 1 per vector;
+ * characters other than 0 and 1, and X when unknowns are allowed, are separators
+ *
+ * unknowns: Read X as DLS_X
+ *
+ * count: Set to the number of complete vectors
+ *
+ * returns: count*num_inputs bytes, or NULL if the file cannot be read
+ */
+static unsigned char* readVectorFile(const char* path, int num_inputs, bool unknowns, uint64_t* count) {
+	FILE* datafile = fopen(path, "r");
+	if(datafile == NULL) {
+		return NULL;
+	}
+	size_t cap = 4096;
+	size_t len = 0;
+	unsigned char* bits = malloc(cap);
+	int ch;
+	while(bits != NULL && (ch = getc(datafile)) != EOF) {
+		bool x = unknowns && (ch == 'X' || ch == 'x');
+		if(ch != '0' && ch != '1' && !x) {
+			continue;
+		}
+		if(len == cap) {
+			cap *= 2;
+			unsigned char* grown = realloc(bits, cap);
+			if(grown == NULL) {
+				free(bits);
+			}
+			bits = grown;
+			if(bits == NULL) {
+				break;
+			}
+		}
+		bits[len++] = x ? DLS_X : ch - '0';
+	}
+	fclose(datafile);
+	*count = (num_inputs > 0) ? len/num_inputs : 0;
+	return bits;
+}
+
+/*
+ * Function: runTernaryTable
+ *
+ * Prints the rows of the --vectors file evaluated in three-valued logic,
+ * X standing for an unknown value
+ *
+ * returns: The exit status
+ */
+static int runTernaryTable(const struct dls_circuit* c, const struct options* opt) {
+	int ni = dlsNumInputs(c);
+	int no = dlsNumOutputs(c);
+	uint64_t count;
+	unsigned char* vectors = readVectorFile(opt->vectors, ni, true, &count);
+	if(vectors == NULL) {
+		fprintf(stderr, "%s: %s\n", opt->vectors, dlsErrorString(DLS_ERR_IO));
+		return 1;
+	}
+	static const char digits[] = {'0', '1', 'X'};
+	unsigned char* out = malloc(count*no + 1);
+	char* buf = malloc(2*(ni + no) + 1);
+	int rc = (out == NULL || buf == NULL) ? DLS_ERR_NOMEM : dlsXEval(c, vectors, out, count);
+	for(uint64_t r = 0; rc == DLS_OK && r < count; r++) {
+		char* p = buf;
+		for(int j = 0; j < ni; j++) {
+			*p++ = digits[vectors[r*ni + j]];
+			*p++ = ' ';
+		}
+		for(int o = 0; o < no; o++) {
+			*p++ = digits[out[r*no + o]];
+			*p++ = ' ';
+		}
+		if(p == buf) {
+			*p++ = ' ';
+		}
+		p[-1] = '\n';
+		fwrite(buf, 1, p - buf, stdout);
+	}
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+	}
+	free(vectors);
+	free(out);
+	free(buf);
+	return (rc == DLS_OK) ? 0 : 1;
+}
+
+/*
+ * Structure: tablectx
+ *
+ * What printBlock needs to print the rows of a scheduled run
+ *
+ * vectors: The vectors of --vectors, NULL for the gray code sweep
+ *
+ * sweep: The rows to print, rounds start up to 63 rows before it
+ *
+ * bit: Gray code bit of each input in the sweep, from dlsSweepBit
+ *
+ */
+struct tablectx {
+	int num_inputs;
+	int num_outputs;
+	const unsigned char* vectors;
+	char* buf;
+	struct sweep sweep;
+	int bit[64];
+};
+
+/*
+ * Function: setSweepBits
+ *
+ * Fills the gray code bit of each input, for sweeps of up to 63 inputs
+ *
+ */
+static void setSweepBits(const struct dls_circuit* c, struct tablectx* t) {
+	for(int j = 0; j < t->num_inputs && j < 64; j++) {
+		t->bit[j] = dlsSweepBit(c, j);
+	}
+}
+
+/*
+ * Function: printBlock
+ *
+ * Prints the rows of one round of dlsSchedRun, 64 rows at a time
+ *
+ */
+static void printBlock(void* arg, uint64_t first, uint64_t count, const uint64_t* out) {
+	struct tablectx* t = arg;
+	int ni = t->num_inputs;
+	int no = t->num_outputs;
+	for(uint64_t w = 0; w*64 < count; w++) {
+		int lanes = (count - w*64 < 64) ? (int)(count - w*64) : 64;
+		char* p = t->buf;
+		for(int k = 0; k < lanes; k++) {
+			uint64_t row = first + w*64 + k;
+			if(row < t->sweep.next) {
+				continue;
+			}
+			uint64_t gray = row ^ (row >> 1);
+			for(int j = 0; j < ni; j++) {
+				*p++ = '0' + (t->vectors ? (t->vectors[row*ni + j] & 1) : (int)((gray >> t->bit[j]) & 1));
+				*p++ = ' ';
+			}
+			for(int o = 0; o < no; o++) {
+				*p++ = '0' + ((out[w*no + o] >> k) & 1);
+				*p++ = ' ';
+			}
+			p[-1] = '\n';
+		}
+		fwrite(t->buf, 1, p - t->buf, stdout);
+		advanceSweep(&t->sweep, first + w*64 + lanes);
+	}
+}
+
+/*
+ * Function: runScheduled
+ *
+ * Prints the truth table, or the rows of the --vectors file, with the work-stealing scheduler
+ *
+ * returns: The exit status
+ */
+static int runScheduled(const struct dls_circuit* c, const struct options* opt) {
+	struct tablectx t = {dlsNumInputs(c), dlsNumOutputs(c), NULL, NULL, {0}};
+	setSweepBits(c, &t);
+	uint64_t count = 0;
+	unsigned char* vectors = NULL;
+	if(opt->vectors != NULL) {
+		vectors = readVectorFile(opt->vectors, t.num_inputs, false, &count);
+		if(vectors == NULL) {
+			fprintf(stderr, "%s: %s\n", opt->vectors, dlsErrorString(DLS_ERR_IO));
+			return 1;
+		}
+	}
+	else if(!canTabulate(opt, t.num_inputs, t.num_outputs)) {
+		return 1;
+	}
+	else {
+		count = (uint64_t)1 << t.num_inputs;
+	}
+	if(openSweep(opt, count, 2*(t.num_inputs + t.num_outputs), &t.sweep) != 0) {
+		free(vectors);
+		return 1;
+	}
+	t.vectors = vectors;
+	uint64_t first = t.sweep.next & ~(uint64_t)63;
+	int threads = dlsSchedThreads(opt->threads);
+	struct dls_sched_stats* stats = calloc(threads, sizeof(struct dls_sched_stats));
+	t.buf = malloc(2*(t.num_inputs + t.num_outputs)*64 + 1);
+	int rc = (stats == NULL || t.buf == NULL) ? DLS_ERR_NOMEM : dlsSchedRun(c, vectors, first, t.sweep.end - first, threads, printBlock, &t, stats);
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+	}
+	else if(opt->stats) {
+		for(int k = 0; k < threads; k++) {
+			fprintf(stderr, "thread %d tasks %llu steals %llu busy %.6fs utilization %.1f%%\n", k,
+					(unsigned long long)stats[k].tasks, (unsigned long long)stats[k].steals,
+					stats[k].busy_seconds, 100*stats[k].utilization);
+		}
+	}
+	free(t.buf);
+	free(stats);
+	free(vectors);
+	return (rc != DLS_OK) | closeSweep(&t.sweep);
+}
+
+/*
+ * Function: runCofactor
+ *
+ * Prints the truth table cofactor by cofactor with dlsCofactorRun
+ *
+ * returns: The exit status
+ */
+static int runCofactor(const struct dls_circuit* c, const struct options* opt) {
+	struct tablectx t = {dlsNumInputs(c), dlsNumOutputs(c), NULL, NULL, {0}};
+	if(!canTabulate(opt, t.num_inputs, t.num_outputs)) {
+		return 1;
+	}
+	setSweepBits(c, &t);
+	if(openSweep(opt, (uint64_t)1 << t.num_inputs, 2*(t.num_inputs + t.num_outputs), &t.sweep) != 0) {
+		return 1;
+	}
+	uint64_t first = t.sweep.next & ~(uint64_t)63;
+	struct dls_cofactor_stats stats;
+	t.buf = malloc(2*(t.num_inputs + t.num_outputs)*64 + 1);
+	int rc = (t.buf == NULL) ? DLS_ERR_NOMEM : dlsCofactorRun(c, opt->cofactor_bits, first, t.sweep.end - first, opt->threads, printBlock, &t, &stats);
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+	}
+	else if(opt->stats) {
+		fprintf(stderr, "fixed inputs %d cofactors %llu gates %d left min %d max %d mean %.1f\n", stats.bits,
+				(unsigned long long)stats.cofactors, stats.gates, stats.min_gates, stats.max_gates, stats.mean_gates);
+	}
+	free(t.buf);
+	return (rc != DLS_OK) | closeSweep(&t.sweep);
+}
+
+/*
+ * Function: runTiled
+ *
+ * Prints the truth table, or the rows of the --vectors file, with cache-blocked evaluation
+ *
+ * returns: The exit status
+ */
+static int runTiled(const struct dls_circuit* c, const struct options* opt) {
+	struct tablectx t = {dlsNumInputs(c), dlsNumOutputs(c), NULL, NULL, {0}};
+	setSweepBits(c, &t);
+	int ni = t.num_inputs;
+	uint64_t count = 0;
+	unsigned char* vectors = NULL;
+	if(opt->vectors != NULL) {
+		vectors = readVectorFile(opt->vectors, ni, false, &count);
+		if(vectors == NULL) {
+			fprintf(stderr, "%s: %s\n", opt->vectors, dlsErrorString(DLS_ERR_IO));
+			return 1;
+		}
+	}
+	else if(!canTabulate(opt, ni, t.num_outputs)) {
+		return 1;
+	}
+	else {
+		count = (uint64_t)1 << ni;
+	}
+	if(openSweep(opt, count, 2*(ni + t.num_outputs), &t.sweep) != 0) {
+		free(vectors);
+		return 1;
+	}
+	count = t.sweep.end;
+	t.vectors = vectors;
+	struct dls_tiling* tiling = dlsTilingNew(c, 0);
+	struct dls_state* s = dlsStateNew(c);
+	long words = (tiling != NULL) ? dlsTilingBlockWords(tiling) : 0;
+	uint64_t* in = malloc((words*ni + 1)*sizeof(uint64_t));
+	uint64_t* out = malloc((words*t.num_outputs + 1)*sizeof(uint64_t));
+	t.buf = malloc(2*(ni + t.num_outputs)*64 + 1);
+	if(tiling == NULL || s == NULL || in == NULL || out == NULL || t.buf == NULL) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(DLS_ERR_NOMEM));
+		count = 0;
+	}
+	else if(opt->stats) {
+		fprintf(stderr, "tiles %d gates per tile %d block words %d spilled nets %d\n", dlsTilingNumTiles(tiling),
+				dlsTilingTileGates(tiling), (int)words, dlsTilingNumSpilled(tiling));
+	}
+	for(uint64_t first = t.sweep.next & ~(uint64_t)63; first < count; first += words*64) {
+		uint64_t rows = (count - first < (uint64_t)words*64) ? count - first : (uint64_t)words*64;
+		long used = (long)((rows + 63)/64);
+		for(long w = 0; w < used; w++) {
+			uint64_t base = first + w*64;
+			if(vectors == NULL) {
+				dlsSetGrayInputs(s, base);
+				for(int i = 0; i < ni; i++) {
+					in[w*ni + i] = dlsGetInput(s, i);
+				}
+				continue;
+			}
+			int lanes = (count - base < 64) ? (int)(count - base) : 64;
+			for(int i = 0; i < ni; i++) {
+				uint64_t word = 0;
+				for(int k = 0; k < lanes; k++) {
+					word |= (uint64_t)(vectors[(base + k)*ni + i] & 1) << k;
+				}
+				in[w*ni + i] = word;
+			}
+		}
+		dlsTilingEval(tiling, used, in, out);
+		printBlock(&t, first, rows, out);
+	}
+	int ret = (tiling == NULL || s == NULL || in == NULL || out == NULL || t.buf == NULL) || closeSweep(&t.sweep);
+	dlsTilingFree(tiling);
+	dlsStateFree(s);
+	free(in);
+	free(out);
+	free(t.buf);
+	free(vectors);
+	return ret;
+}
+
+/*
+ * Function: runFaults
+ *
+ * Reports the stuck-at fault coverage of a vector set, then lists the undetected faults
+ *
+ * returns: The exit status
+ */
+static int runFaults(const struct dls_circuit* c, const struct options* opt) {
+	unsigned char* vectors = NULL;
+	uint64_t count = 0;
+	if(opt->vectors != NULL) {
+		vectors = readVectorFile(opt->vectors, dlsNumInputs(c), false, &count);
+		if(vectors == NULL) {
+			fprintf(stderr, "%s: %s\n", opt->vectors, dlsErrorString(DLS_ERR_IO));
+			return 1;
+		}
+	}
+	int num_faults = dlsNumFaults(c);
+	unsigned char* detected = malloc(num_faults + 1);
+	int rc = (detected == NULL) ? DLS_ERR_NOMEM : dlsFaultSim(c, vectors, count, opt->threads, detected);
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+		free(vectors);
+		free(detected);
+		return 1;
+	}
+	int found = 0;
+	for(int f = 0; f < num_faults; f++) {
+		found += detected[f];
+	}
+	printf("faults %d\n", num_faults);
+	printf("detected %d\n", found);
+	printf("coverage %.2f%%\n", num_faults ? 100.0*found/num_faults : 100.0);
+	for(int f = 0; f < num_faults; f++) {
+		if(!detected[f]) {
+			printf("undetected %s stuck-at-%d\n", dlsNetName(c, f/2 + 2), f % 2);
+		}
+	}
+	free(vectors);
+	free(detected);
+	return 0;
+}
+
+/*
+ * Function: printJsonString
+ *
+ * Prints a net name as a JSON string
+ *
+ */
+static void printJsonString(const char* str) {
+	putchar('"');
+	for(; *str != '\0'; str++) {
+		if(*str == '"' || *str == '\\') {
+			putchar('\\');
+		}
+		if((unsigned char)*str < 0x20) {
+			printf("\\u%04x", *str);
+			continue;
+		}
+		putchar(*str);
+	}
+	putchar('"');
+}
+
+/*
+ * Function: runActivity
+ *
+ * Prints the per-net switching activity as CSV or JSON
+ * activity is the fraction of consecutive vector pairs where the net toggles
+ *
+ * returns: The exit status
+ */
+static int runActivity(const struct dls_circuit* c, const struct options* opt) {
+	unsigned char* vectors = NULL;
+	uint64_t count = 0; //The full sweep, whose width dlsActivity checks
+	if(opt->vectors != NULL) {
+		vectors = readVectorFile(opt->vectors, dlsNumInputs(c), false, &count);
+		if(vectors == NULL) {
+			fprintf(stderr, "%s: %s\n", opt->vectors, dlsErrorString(DLS_ERR_IO));
+			return 1;
+		}
+	}
+	int num_nets = dlsNumNets(c);
+	uint64_t* rises = malloc(num_nets*sizeof(uint64_t));
+	uint64_t* falls = malloc(num_nets*sizeof(uint64_t));
+	int rc = (rises == NULL || falls == NULL) ? DLS_ERR_NOMEM : dlsActivity(c, vectors, count, rises, falls);
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+		free(vectors);
+		free(rises);
+		free(falls);
+		return 1;
+	}
+	if(vectors == NULL) {
+		count = (uint64_t)1 << dlsNumInputs(c);
+	}
+	double pairs = (count > 1) ? (double)(count - 1) : 1.0;
+	if(opt->json) {
+		printf("{\"vectors\": %llu, \"nets\": [", (unsigned long long)count);
+	}
+	else {
+		printf("net,rises,falls,toggles,activity\n");
+	}
+	for(int net = 2; net < num_nets; net++) { //Skip the constants
+		unsigned long long r = rises[net];
+		unsigned long long f = falls[net];
+		if(opt->json) {
+			printf("%s\n  {\"net\": ", (net == 2) ? "" : ",");
+			printJsonString(dlsNetName(c, net));
+			printf(", \"rises\": %llu, \"falls\": %llu, \"toggles\": %llu, \"activity\": %.6f}", r, f, r + f, (r + f)/pairs);
+		}
+		else {
+			printf("%s,%llu,%llu,%llu,%.6f\n", dlsNetName(c, net), r, f, r + f, (r + f)/pairs);
+		}
+	}
+	if(opt->json) {
+		printf("\n]}\n");
+	}
+	free(vectors);
+	free(rises);
+	free(falls);
+	return 0;
+}
+
+/*
+ * Function: readDelays
+ *
+ * Reads a delay file into a timing: one "name delay" pair per line, the name
+ * a gate type or a net driven by a gate; # starts a comment
+ *
+ * returns: DLS_OK, or the error of the first line that cannot be used
+ */
+static int readDelays(const struct dls_circuit* c, struct dls_timing* t, const char* path) {
+	FILE* file = fopen(path, "r");
+	if(file == NULL) {
+		fprintf(stderr, "%s: %s\n", path, dlsErrorString(DLS_ERR_IO));
+		return DLS_ERR_IO;
+	}
+	char* line = NULL;
+	size_t cap = 0;
+	int rc = DLS_OK;
+	for(long number = 1; rc == DLS_OK && getline(&line, &cap, file) != -1; number++) {
+		char* comment = strchr(line, '#');
+		if(comment != NULL) {
+			*comment = '\0';
+		}
+		char* name = strtok(line, " \t\r\n");
+		if(name == NULL) {
+			continue;
+		}
+		char* value = strtok(NULL, " \t\r\n");
+		char* end = NULL;
+		long delay = (value != NULL) ? strtol(value, &end, 10) : -1;
+		if(value == NULL || *end != '\0' || strtok(NULL, " \t\r\n") != NULL) {
+			rc = DLS_ERR_SYNTAX;
+		}
+		else if(dlsTimingSetTypeDelay(t, name, (int)delay) != DLS_OK) {
+			int net = dlsFindNet(c, name);
+			rc = (net < 0) ? DLS_ERR_ARG : dlsTimingSetDelay(t, net, (int)delay);
+		}
+		if(rc != DLS_OK) {
+			fprintf(stderr, "%s:%ld: %s\n", path, number, dlsErrorString(rc));
+		}
+	}
+	free(line);
+	fclose(file);
+	return rc;
+}
+
+/*
+ * Function: runTiming
+ *
+ * Runs the timed sweep and prints the settle time, transitions and glitches of
+ * every output, as CSV or JSON
+ *
+ * returns: The exit status
+ */
+static int runTiming(const struct dls_circuit* c, const struct options* opt) {
+	int no = dlsNumOutputs(c);
+	struct dls_timing* t = dlsTimingNew(c);
+	struct dls_timing_stats* stats = malloc((no + 1)*sizeof(struct dls_timing_stats));
+	if(t == NULL || stats == NULL) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(DLS_ERR_NOMEM));
+		dlsTimingFree(t);
+		free(stats);
+		return 1;
+	}
+	int rc = (opt->delays != NULL) ? readDelays(c, t, opt->delays) : DLS_OK;
+	if(rc == DLS_OK) {
+		rc = dlsTimingSweep(t, stats);
+		if(rc != DLS_OK) {
+			fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+		}
+	}
+	if(rc == DLS_OK) {
+		if(opt->json) {
+			printf("{\"input_transitions\": %llu, \"outputs\": [", (unsigned long long)((uint64_t)1 << dlsNumInputs(c)) - 1);
+		}
+		else {
+			printf("output,transitions,glitches,steps,max_settle,mean_settle\n");
+		}
+		for(int o = 0; o < no; o++) {
+			const struct dls_timing_stats* st = &stats[o];
+			if(opt->json) {
+				printf("%s\n  {\"output\": ", (o == 0) ? "" : ",");
+				printJsonString(dlsOutputName(c, o));
+				printf(", \"transitions\": %llu, \"glitches\": %llu, \"steps\": %llu, \"max_settle\": %ld, \"mean_settle\": %.3f}",
+						(unsigned long long)st->transitions, (unsigned long long)st->glitches, (unsigned long long)st->steps, st->max_settle, st->mean_settle);
+			}
+			else {
+				printf("%s,%llu,%llu,%llu,%ld,%.3f\n", dlsOutputName(c, o), (unsigned long long)st->transitions,
+						(unsigned long long)st->glitches, (unsigned long long)st->steps, st->max_settle, st->mean_settle);
+			}
+		}
+		if(opt->json) {
+			printf("\n]}\n");
+		}
+		if(opt->stats) {
+			fprintf(stderr, "events: %llu\n", (unsigned long long)dlsTimingNumEvents(t));
+		}
+	}
+	dlsTimingFree(t);
+	free(stats);
+	return (rc == DLS_OK) ? 0 : 1;
+}
+
+/*
+ * Function: printIntArray
+ *
+ * Prints a JSON array of ints
+ *
+ */
+static void printIntArray(const int* v, int count) {
+	putchar('[');
+	for(int k = 0; k < count; k++) {
+		printf("%s%d", (k == 0) ? "" : ", ", v[k]);
+	}
+	putchar(']');
+}
+
+/*
+ * Function: sweepEvaluations
+ *
+ * Estimates the gates an incremental sweep re-evaluates: over the 2^n rows, the bit
+ * b of the gray code changes 2^(n-1-b) times, each time re-evaluating the fanout
+ * cone of its input
+ *
+ * fanout: True for the order of dlsFanoutOrder, false for the INPUTVAR order
+ *
+ * returns: The estimate, or 0 if the order cannot be computed
+ */
+static double sweepEvaluations(const struct dls_circuit* c, const struct dls_analysis* a, bool fanout) {
+	int n = dlsNumInputs(c);
+	int* order = malloc((n + 1)*sizeof(int));
+	if(order == NULL || (fanout && dlsFanoutOrder(c, order) != DLS_OK)) {
+		free(order);
+		return 0;
+	}
+	double total = 0;
+	for(int k = 0; k < n; k++) {
+		int input = fanout ? order[k] : k;
+		total += ldexp(a->input_cone[input], k); //Order k takes bit n-1-k
+	}
+	free(order);
+	return total;
+}
+
+/*
+ * Function: runAnalyze
+ *
+ * Prints the shape of the circuit from dlsAnalyze as one JSON object
+ *
+ * returns: The exit status
+ */
+static int runAnalyze(const struct dls_circuit* c, const struct options* opt) {
+	struct dls_analysis a;
+	int rc = dlsAnalyze(c, &a);
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(rc));
+		dlsAnalysisFree(&a);
+		return 1;
+	}
+	printf("{\"inputs\": %d, \"outputs\": %d, \"nets\": %d, \"gates\": %d, \"flip_flops\": %d,\n \"gate_types\": {",
+			dlsNumInputs(c), dlsNumOutputs(c), dlsNumNets(c), dlsNumGates(c), dlsNumRegisters(c));
+	for(int t = 0; t < DLS_GATE_TYPES; t++) {
+		printf("%s\"%s\": %d", (t == 0) ? "" : ", ", dlsGateTypeName(t), a.gate_types[t]);
+	}
+	int max_width = 0;
+	for(int l = 0; l < a.num_levels; l++) {
+		max_width = (a.level_width[l] > max_width) ? a.level_width[l] : max_width;
+	}
+	printf("},\n \"depth\": %d, \"max_width\": %d, \"level_width\": ", a.num_levels, max_width);
+	printIntArray(a.level_width, a.num_levels);
+	long long nets = 0, reads = 0;
+	for(int f = 0; f <= a.max_fanout; f++) {
+		nets += a.fanout[f];
+		reads += (long long)f*a.fanout[f];
+	}
+	printf(",\n \"fanout\": {\"max\": %d, \"mean\": %.3f, \"histogram\": ", a.max_fanout, (nets > 0) ? (double)reads/nets : 0);
+	printIntArray(a.fanout, a.max_fanout + 1);
+	printf("},\n \"cones\": [");
+	for(int o = 0; o < dlsNumOutputs(c); o++) {
+		printf("%s\n  {\"output\": ", (o == 0) ? "" : ",");
+		printJsonString(dlsOutputName(c, o));
+		printf(", \"support\": %d, \"gates\": %d}", a.support[o], a.cone[o]);
+	}
+	printf("\n ],\n \"input_cones\": ");
+	printIntArray(a.input_cone, dlsNumInputs(c));
+	printf(",\n \"sweep_evaluations\": {\"inputs\": %.0f, \"fanout\": %.0f}",
+			sweepEvaluations(c, &a, false), sweepEvaluations(c, &a, true));
+	printf(",\n \"longest_path\": {\"gates\": %d, \"nets\": [", a.path_length);
+	for(int k = 0; k <= a.path_length; k++) {
+		printf("%s", (k == 0) ? "" : ", ");
+		printJsonString(dlsNetName(c, a.path[k]));
+	}
+	printf("]}}\n");
+	dlsAnalysisFree(&a);
+	return 0;
+}
+
+/*
+ * Function: dumpSamples
+ *
+ * Evaluates the random vectors of --monte-carlo one word at a time, writing their
+ * rows to the dump file and counting the ones of each output
+ * The rows are written in order from one thread, so --threads is not taken with --dump
+ *
+ * returns: DLS_OK, DLS_ERR_IO or DLS_ERR_NOMEM
+ */
+static int dumpSamples(const struct dls_circuit* c, const struct options* opt, uint64_t* ones) {
+	int num_inputs = dlsNumInputs(c);
+	int num_outputs = dlsNumOutputs(c);
+	FILE* dump = fopen(opt->dump, "w");
+	if(dump == NULL) {
+		return DLS_ERR_IO;
+	}
+	struct dls_state* s = dlsStateNew(c);
+	uint64_t* words = malloc((num_inputs + num_outputs)*sizeof(uint64_t)); //Inputs, then outputs
+	char* buf = malloc(2*(num_inputs + num_outputs)*64 + 1);
+	int rc = (s == NULL || words == NULL || buf == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+	memset(ones, 0, num_outputs*sizeof(uint64_t));
+	for(uint64_t base = 0; rc == DLS_OK && base < opt->samples; base += 64) {
+		int lanes = (opt->samples - base < 64) ? (int)(opt->samples - base) : 64;
+		uint64_t mask = (lanes == 64) ? ~(uint64_t)0 : (((uint64_t)1 << lanes) - 1);
+		dlsSetRandomInputs(s, opt->seed, base/64);
+		for(int j = 0; j < num_inputs; j++) {
+			words[j] = dlsGetInput(s, j);
+		}
+		dlsEvalWords(c, s);
+		for(int o = 0; o < num_outputs; o++) {
+			words[num_inputs + o] = dlsGetOutput(s, o);
+			ones[o] += __builtin_popcountll(words[num_inputs + o] & mask);
+		}
+		char* p = formatRows(num_inputs, num_outputs, 0, lanes, words, words + num_inputs, buf);
+		fwrite(buf, 1, p - buf, dump);
+	}
+	if(fclose(dump) != 0 && rc == DLS_OK) {
+		rc = DLS_ERR_IO;
+	}
+	free(buf);
+	free(words);
+	dlsStateFree(s);
+	return rc;
+}
+
+/*
+ * Function: runMonteCarlo
+ *
+ * Prints the probability of each output being 1 over random vectors, with its
+ * 95% Wilson score interval
+ *
+ * returns: The exit status
+ */
+static int runMonteCarlo(const struct dls_circuit* c, const struct options* opt) {
+	int num_outputs = dlsNumOutputs(c);
+	uint64_t* ones = malloc((num_outputs + 1)*sizeof(uint64_t));
+	int rc = DLS_ERR_NOMEM;
+	if(ones != NULL) {
+		rc = (opt->dump != NULL) ? dumpSamples(c, opt, ones) : dlsMonteCarlo(c, opt->seed, opt->samples, opt->threads, ones);
+	}
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", (rc == DLS_ERR_IO) ? opt->dump : opt->circuit, dlsErrorString(rc));
+		free(ones);
+		return 1;
+	}
+	double n = (double)opt->samples;
+	double z2 = CONFIDENCE_Z*CONFIDENCE_Z;
+	if(opt->json) {
+		printf("{\"vectors\": %llu, \"seed\": %llu, \"outputs\": [", (unsigned long long)opt->samples, (unsigned long long)opt->seed);
+	}
+	else {
+		printf("output,ones,probability,low,high\n");
+	}
+	for(int o = 0; o < num_outputs; o++) {
+		double p = (n > 0) ? ones[o]/n : 0;
+		double low = 0;
+		double high = 1;
+		if(n > 0) {
+			double denom = 1 + z2/n;
+			double center = (p + z2/(2*n))/denom;
+			double half = CONFIDENCE_Z*sqrt(p*(1 - p)/n + z2/(4*n*n))/denom;
+			low = (center - half < 0) ? 0 : center - half;
+			high = (center + half > 1) ? 1 : center + half;
+		}
+		if(opt->json) {
+			printf("%s\n  {\"output\": ", (o == 0) ? "" : ",");
+			printJsonString(dlsOutputName(c, o));
+			printf(", \"ones\": %llu, \"probability\": %.6f, \"low\": %.6f, \"high\": %.6f}", (unsigned long long)ones[o], p, low, high);
+		}
+		else {
+			printf("%s,%llu,%.6f,%.6f,%.6f\n", dlsOutputName(c, o), (unsigned long long)ones[o], p, low, high);
+		}
+	}
+	if(opt->json) {
+		printf("\n]}\n");
+	}
+	free(ones);
+	return 0;
+}
+
+/*
+ * Function: setMode
+ *
+ * Sets the mode of a mode flag, marking the command line bad if it already named another
+ *
+ */
+static void setMode(struct options* opt, int mode) {
+	if(opt->mode != MODE_TABLE && opt->mode != mode) {
+		opt->bad = true;
+	}
+	opt->mode = mode;
+}
+
+/*
+ * Function: validOptions
+ *
+ * Checks that the command line names a circuit, that its values are in range, and
+ * that every option it gives is read by the mode and table engine it selects, so
+ * that none is silently ignored or overridden
+ *
+ * returns: False if the usage should be printed
+ */
+static bool validOptions(const struct options* opt) {
+	if(opt->bad || opt->circuit == NULL || opt->streams < 1 || opt->streams > 64 || opt->shards < 1 || opt->shard < 0 || opt->shard >= opt->shards) {
+		return false;
+	}
+	/*Table engines, of which one at most is picked; --support also feeds -o*/
+	int engines = opt->level_parallel + opt->threaded + opt->work_stealing + opt->tiled + (opt->cofactor_bits >= -1) + opt->ternary + opt->support;
+	bool sweeps = (opt->mode == MODE_TABLE && !opt->ternary);
+	bool table_vectors = (opt->work_stealing || opt->tiled || opt->ternary);
+	if(engines > 1 || (engines > 0 && opt->mode != MODE_TABLE && !(opt->ternary && opt->mode == MODE_CYCLES))) {
+		return false;
+	}
+	if(opt->ternary && opt->mode == MODE_TABLE && opt->vectors == NULL) {
+		return false;
+	}
+	if(opt->vectors != NULL && opt->mode != MODE_FAULTS && opt->mode != MODE_ACTIVITY && !(opt->mode == MODE_TABLE && table_vectors)) {
+		return false;
+	}
+	if(opt->output != NULL && (opt->mode != MODE_TABLE || (engines > 0 && !opt->support) || opt->checkpoint != NULL)) {
+		return false;
+	}
+	if(!sweeps && (opt->range_start != 0 || opt->range_end != UINT64_MAX || opt->shards > 1 || opt->checkpoint != NULL)) {
+		return false;
+	}
+	if(opt->mode == MODE_CYCLES ? (opt->cycles < 0 || opt->stimulus == NULL) : (opt->stimulus != NULL && opt->mode != MODE_SERVE)) {
+		return false;
+	}
+	/*Modes and engines that run on several threads, and those that print --stats*/
+	bool threads = (opt->mode == MODE_FAULTS || (opt->mode == MODE_MONTECARLO && opt->dump == NULL) || opt->mode == MODE_SERVE
+			|| (opt->mode == MODE_TABLE && (opt->level_parallel || opt->work_stealing || opt->cofactor_bits >= -1 || opt->output != NULL)));
+	bool stats = (sweeps || opt->mode == MODE_SUPPORT || opt->mode == MODE_TIMING || opt->mode == MODE_SERVE);
+	if((opt->threads_set && !threads) || (opt->stats && !stats) || (opt->seed_set && opt->mode != MODE_MONTECARLO)) {
+		return false;
+	}
+	return (opt->streams == 1 || opt->mode == MODE_CYCLES) && (opt->delays == NULL || opt->mode == MODE_TIMING)
+			&& (opt->dump == NULL || opt->mode == MODE_MONTECARLO)
+			&& (!opt->format_set || opt->mode == MODE_ACTIVITY || opt->mode == MODE_TIMING || opt->mode == MODE_MONTECARLO);
+}
+
+/*
+ * Function: setFanoutOrder
+ *
+ * Sweeps the inputs of --gray-order fanout in the order of dlsFanoutOrder
+ *
+ * returns: DLS_OK, or the error of dlsFanoutOrder or dlsSetSweepOrder
+ */
+static int setFanoutOrder(struct dls_circuit* c) {
+	int* order = malloc((dlsNumInputs(c) + 1)*sizeof(int));
+	int rc = (order == NULL) ? DLS_ERR_NOMEM : dlsFanoutOrder(c, order);
+	if(rc == DLS_OK) {
+		rc = dlsSetSweepOrder(c, order);
+	}
+	free(order);
+	return rc;
+}
+
+/*
+ * Function: loadCircuit
+ *
+ * Loads, flattens if asked, and compiles a circuit file, printing any error
+ *
+ * returns: The circuit, or NULL
+ */
+static struct dls_circuit* loadCircuit(const char* path, const struct options* opt) {
+	struct dls_circuit* c;
+	int rc = dlsLoadFile(&c, path);
+	if(rc == DLS_OK && opt->flatten) {
+		rc = dlsFlatten(c);
+	}
+	if(rc == DLS_OK) {
+		rc = dlsCompile(c);
+	}
+	if(rc == DLS_OK && opt->fanout_order) {
+		rc = setFanoutOrder(c);
+	}
+	if(rc != DLS_OK) {
+		fprintf(stderr, "%s: %s\n", path, dlsErrorString(rc));
+		dlsFree(c);
+		return NULL;
+	}
+	return c;
+}
+
+/*
+ * Structure: request
+ *
+ * Header of a --serve request, in host byte order, followed by count vectors of
+ * (inputs+7)/8 bytes each, input i being bit i%8 of byte i/8
+ *
+ * circuit: Index of the circuit, in the order of the command line
+ *
+ */
+struct request {
+	uint32_t circuit;
+	uint32_t count;
+};
+
+/*
+ * Structure: reply
+ *
+ * Header of a --serve reply, followed by count vectors of (outputs+7)/8 bytes packed
+ * like the inputs
+ *
+ * status: DLS_OK, or DLS_ERR_ARG for an unknown circuit or too many vectors, or
+ *	DLS_ERR_NOMEM; the server closes the connection after an error
+ *
+ */
+struct reply {
+	int32_t status;
+	uint32_t count;
+	uint32_t num_inputs;
+	uint32_t num_outputs;
+};
+
+/*
+ * Structure: server
+ *
+ * Shared by the workers of runServe
+ *
+ * listen_fd: The listening socket, non-blocking so that workers that lose the race
+ *	for a connection go back to waiting
+ *
+ * stop_fd: Read end of a pipe that becomes readable when the server stops
+ *
+ */
+struct server {
+	struct dls_circuit** circuits;
+	int num_circuits;
+	int listen_fd;
+	int stop_fd;
+};
+
+/*
+ * Structure: worker
+ *
+ * One thread of runServe, with its own state for each circuit and its own buffers
+ *
+ * busy, max_busy: Seconds from reading the header of a request to sending its reply
+ *
+ */
+struct worker {
+	const struct server* server;
+	pthread_t tid;
+	struct dls_state** states;
+	unsigned char* in;
+	unsigned char* out;
+	size_t in_size;
+	size_t out_size;
+	uint64_t connections;
+	uint64_t requests;
+	uint64_t vectors;
+	double busy;
+	double max_busy;
+};
+
+/*
+ * Function: waitReadable
+ *
+ * Waits for a descriptor to have data, or to be closed, unless the server stops first
+ *
+ * timeout: Milliseconds to wait, -1 for no limit
+ *
+ * returns: False if the server is stopping or the time ran out
+ */
+static bool waitReadable(int fd, int stop_fd, int timeout) {
+	struct pollfd p[2] = {{fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+	for(;;) {
+		int n = poll(p, 2, timeout);
+		if(n > 0) {
+			return p[1].revents == 0;
+		}
+		if(n == 0 || errno != EINTR) {
+			return false;
+		}
+	}
+}
+
+/*
+ * Function: readFull
+ *
+ * Reads len bytes, waiting at most timeout milliseconds for each part of them
+ *
+ * returns: True if all len bytes were read, false on end of file, error, timeout,
+ *	or when the server stops
+ */
+static bool readFull(int fd, int stop_fd, void* buf, size_t len, int timeout) {
+	unsigned char* p = buf;
+	while(len > 0) {
+		if(!waitReadable(fd, stop_fd, timeout)) {
+			return false;
+		}
+		ssize_t n = read(fd, p, len);
+		if(n <= 0) {
+			if(n < 0 && errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/*
+ * Function: sendFull
+ *
+ * Sends all len bytes without raising SIGPIPE when the client has gone; a send
+ * blocked for SERVE_IO_MS fails through the socket's SO_SNDTIMEO
+ *
+ * returns: True if all len bytes were sent
+ */
+static bool sendFull(int fd, const void* buf, size_t len) {
+	const unsigned char* p = buf;
+	while(len > 0) {
+		ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/*
+ * Function: growBuffer
+ *
+ * returns: False if the buffer could not be grown to need bytes
+ */
+static bool growBuffer(unsigned char** buf, size_t* size, size_t need) {
+	if(need <= *size) {
+		return true;
+	}
+	unsigned char* grown = realloc(*buf, need);
+	if(grown == NULL) {
+		return false;
+	}
+	*buf = grown;
+	*size = need;
+	return true;
+}
+
+/*
+ * Function: evalPacked
+ *
+ * Evaluates vectors packed one bit per input, 64 at a time, into vectors packed one
+ * bit per output
+ *
+ */
+static void evalPacked(const struct dls_circuit* c, struct dls_state* s, const unsigned char* in, unsigned char* out, uint32_t count) {
+	int ni = dlsNumInputs(c);
+	int no = dlsNumOutputs(c);
+	size_t in_bytes = (ni + 7)/8;
+	size_t out_bytes = (no + 7)/8;
+	memset(out, 0, count*out_bytes);
+	for(uint32_t base = 0; base < count; base += 64) {
+		int lanes = (count - base < 64) ? (int)(count - base) : 64;
+		for(int i = 0; i < ni; i++) {
+			const unsigned char* p = in + base*in_bytes + i/8;
+			uint64_t word = 0;
+			for(int k = 0; k < lanes; k++) {
+				word |= (uint64_t)((p[k*in_bytes] >> (i % 8)) & 1) << k;
+			}
+			dlsSetInput(s, i, word);
+		}
+		dlsEvalWords(c, s);
+		for(int o = 0; o < no; o++) {
+			unsigned char* p = out + base*out_bytes + o/8;
+			uint64_t word = dlsGetOutput(s, o);
+			for(int k = 0; k < lanes; k++) {
+				p[k*out_bytes] |= ((word >> k) & 1) << (o % 8);
+			}
+		}
+	}
+}
+
+/*
+ * Function: serveConnection
+ *
+ * Answers the requests of one client until it disconnects, sends a request that
+ * fails, stays idle for SERVE_IDLE_MS, stalls for SERVE_IO_MS within a request or
+ * its reply, or the server stops
+ *
+ */
+static void serveConnection(struct worker* w, int fd) {
+	const struct server* sv = w->server;
+	struct request req;
+	while(readFull(fd, sv->stop_fd, &req, sizeof(req), SERVE_IDLE_MS)) {
+		double begin = seconds();
+		struct reply rep = {DLS_OK, req.count, 0, 0};
+		struct dls_circuit* c = (req.circuit < (uint32_t)sv->num_circuits) ? sv->circuits[req.circuit] : NULL;
+		size_t in_len = 0;
+		size_t out_len = sizeof(rep);
+		if(c == NULL || req.count > SERVE_MAX_VECTORS) {
+			rep.status = DLS_ERR_ARG;
+		}
+		else {
+			rep.num_inputs = dlsNumInputs(c);
+			rep.num_outputs = dlsNumOutputs(c);
+			in_len = (size_t)req.count*((rep.num_inputs + 7)/8);
+			out_len += (size_t)req.count*((rep.num_outputs + 7)/8);
+			if(w->states[req.circuit] == NULL) {
+				w->states[req.circuit] = dlsStateNew(c);
+			}
+			if(w->states[req.circuit] == NULL || !growBuffer(&w->in, &w->in_size, in_len + 1) || !growBuffer(&w->out, &w->out_size, out_len)) {
+				rep.status = DLS_ERR_NOMEM;
+			}
+		}
+		if(rep.status != DLS_OK) {
+			rep.count = 0;
+			sendFull(fd, &rep, sizeof(rep));
+			return;
+		}
+		if(!readFull(fd, sv->stop_fd, w->in, in_len, SERVE_IO_MS)) {
+			return;
+		}
+		evalPacked(c, w->states[req.circuit], w->in, w->out + sizeof(rep), req.count);
+		memcpy(w->out, &rep, sizeof(rep));
+		if(!sendFull(fd, w->out, out_len)) {
+			return;
+		}
+		double busy = seconds() - begin;
+		w->requests++;
+		w->vectors += req.count;
+		w->busy += busy;
+		w->max_busy = (busy > w->max_busy) ? busy : w->max_busy;
+	}
+}
+
+/*
+ * Function: serveWorker
+ *
+ * Accepts connections and serves each until it ends, until the server stops
+ *
+ */
+static void* serveWorker(void* arg) {
+	struct worker* w = arg;
+	const struct server* sv = w->server;
+	struct timeval send_timeout = {SERVE_IO_MS/1000, (SERVE_IO_MS % 1000)*1000};
+	while(waitReadable(sv->listen_fd, sv->stop_fd, -1)) {
+		int fd = accept(sv->listen_fd, NULL, NULL);
+		if(fd < 0) {
+			continue; //Another worker took the connection
+		}
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+		w->connections++;
+		serveConnection(w, fd);
+		close(fd);
+	}
+	return NULL;
+}
+
+/*
+ * Function: listenUnix
+ *
+ * Binds and listens on a Unix socket, replacing a socket left by an earlier server
+ *
+ * returns: The non-blocking listening socket, or -1 with errno set
+ */
+static int listenUnix(const char* path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+	struct stat st;
+	if(stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+		unlink(path);
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0) {
+		return -1;
+	}
+	if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0
+			|| fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	return fd;
+}
+
+/*
+ * Function: runServe
+ *
+ * Keeps every circuit of the command line compiled and answers the requests sent to
+ * the --serve socket from a pool of --threads workers, each taking one connection at
+ * a time, until SIGINT or SIGTERM
+ *
+ * c: The first circuit, already loaded; the others are loaded here
+ *
+ * returns: The exit status
+ */
+static int runServe(struct dls_circuit* c, const struct options* opt) {
+	struct server sv = {NULL, opt->num_paths, -1, -1};
+	int threads = dlsSchedThreads(opt->threads);
+	sv.circuits = calloc(sv.num_circuits, sizeof(struct dls_circuit*));
+	struct worker* workers = calloc(threads, sizeof(struct worker));
+	int stop[2] = {-1, -1};
+	bool failed = (sv.circuits == NULL || workers == NULL);
+	if(failed) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(DLS_ERR_NOMEM));
+	}
+	for(int k = 0; !failed && k < sv.num_circuits; k++) {
+		sv.circuits[k] = (k == 0) ? c : loadCircuit(opt->paths[k], opt);
+		failed = (sv.circuits[k] == NULL);
+	}
+	if(!failed && ((sv.listen_fd = listenUnix(opt->socket)) < 0 || pipe(stop) != 0)) {
+		perror(opt->socket);
+		failed = true;
+	}
+	sv.stop_fd = stop[0];
+	/*Only the main thread takes the signals, in sigwait*/
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+	int started = 0;
+	for(int t = 0; !failed && t < threads; t++) {
+		workers[t].server = &sv;
+		workers[t].states = calloc(sv.num_circuits, sizeof(struct dls_state*));
+		if(workers[t].states == NULL || pthread_create(&workers[t].tid, NULL, serveWorker, &workers[t]) != 0) {
+			free(workers[t].states);
+			break;
+		}
+		started++;
+	}
+	if(!failed && started == 0) {
+		fprintf(stderr, "%s: %s\n", opt->circuit, dlsErrorString(DLS_ERR_NOMEM));
+	}
+	else if(!failed) {
+		int sig;
+		sigwait(&signals, &sig);
+		if(write(stop[1], "", 1) != 1) {
+			perror("write");
+		}
+	}
+	for(int t = 0; t < started; t++) {
+		pthread_join(workers[t].tid, NULL);
+		if(opt->stats) {
+			struct worker* w = &workers[t];
+			fprintf(stderr, "worker %d connections %llu requests %llu vectors %llu mean %.1fus max %.1fus\n", t,
+					(unsigned long long)w->connections, (unsigned long long)w->requests, (unsigned long long)w->vectors,
+					(w->requests > 0) ? 1e6*w->busy/w->requests : 0, 1e6*w->max_busy);
+		}
+		for(int k = 0; k < sv.num_circuits; k++) {
+			dlsStateFree(workers[t].states[k]);
+		}
+		free(workers[t].states);
+		free(workers[t].in);
+		free(workers[t].out);
+	}
+	if(sv.listen_fd >= 0) {
+		close(sv.listen_fd);
+		unlink(opt->socket);
+	}
+	if(stop[0] >= 0) {
+		close(stop[0]);
+		close(stop[1]);
+	}
+	for(int k = 1; sv.circuits != NULL && k < sv.num_circuits; k++) {
+		dlsFree(sv.circuits[k]);
+	}
+	free(sv.circuits);
+	free(workers);
+	return failed || started == 0;
+}
+
+int main(int argc, char** argv) {
+	struct options opt = {MODE_TABLE, NULL, NULL, -1, 1, false, NULL, 0, false, false, false, false, false, false, -2, false, false, 0, UINT64_MAX, 0, 1, NULL, 0, 0, NULL, NULL, NULL, false, NULL, NULL, 0, false, false, false, false};
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+			setMode(&opt, MODE_CYCLES);
+			opt.cycles = atol(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--streams") == 0 && i + 1 < argc) {
+			opt.streams = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--flatten") == 0) {
+			opt.flatten = true;
+		}
+		else if(strcmp(argv[i], "--faults") == 0) {
+			setMode(&opt, MODE_FAULTS);
+			opt.flatten = true;
+		}
+		else if(strcmp(argv[i], "--activity") == 0) {
+			setMode(&opt, MODE_ACTIVITY);
+			opt.flatten = true;
+		}
+		else if(strcmp(argv[i], "--timing") == 0) {
+			setMode(&opt, MODE_TIMING);
+			opt.flatten = true;
+		}
+		else if(strcmp(argv[i], "--analyze") == 0) {
+			setMode(&opt, MODE_ANALYZE);
+		}
+		else if(strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+			setMode(&opt, MODE_SERVE);
+			opt.socket = argv[++i];
+		}
+		else if(strcmp(argv[i], "--delays") == 0 && i + 1 < argc) {
+			opt.delays = argv[++i];
+		}
+		else if(strcmp(argv[i], "--monte-carlo") == 0 && i + 1 < argc) {
+			setMode(&opt, MODE_MONTECARLO);
+			opt.samples = strtoull(argv[++i], NULL, 10);
+		}
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			opt.seed = strtoull(argv[++i], NULL, 0);
+			opt.seed_set = true;
+		}
+		else if(strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+			opt.dump = argv[++i];
+		}
+		else if(strcmp(argv[i], "--level-parallel") == 0) {
+			opt.level_parallel = true;
+		}
+		else if(strcmp(argv[i], "--work-stealing") == 0) {
+			opt.work_stealing = true;
+		}
+		else if(strcmp(argv[i], "--threaded") == 0) {
+			opt.threaded = true;
+		}
+		else if(strcmp(argv[i], "--cofactor") == 0) {
+			opt.cofactor_bits = -1;
+		}
+		else if(strcmp(argv[i], "--cofactor-bits") == 0 && i + 1 < argc) {
+			opt.cofactor_bits = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--support") == 0) {
+			opt.support = true;
+		}
+		else if(strcmp(argv[i], "--support-tables") == 0) {
+			setMode(&opt, MODE_SUPPORT);
+		}
+		else if(strcmp(argv[i], "--ternary") == 0) {
+			opt.ternary = true;
+		}
+		else if(strcmp(argv[i], "--tiled") == 0) {
+			opt.tiled = true;
+		}
+		else if(strcmp(argv[i], "--range") == 0 && i + 1 < argc) {
+			char* end;
+			opt.range_start = strtoull(argv[++i], &end, 0);
+			if(*end != ':') {
+				opt.bad = true;
+			}
+			else if(end[1] != '\0') {
+				opt.range_end = strtoull(end + 1, NULL, 0);
+			}
+		}
+		else if(strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+			if(sscanf(argv[++i], "%d/%d", &opt.shard, &opt.shards) != 2) {
+				opt.bad = true;
+			}
+		}
+		else if((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
+			opt.output = argv[++i];
+		}
+		else if(strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+			opt.checkpoint = argv[++i];
+		}
+		else if(strcmp(argv[i], "--gray-order") == 0 && i + 1 < argc) {
+			i++;
+			opt.fanout_order = (strcmp(argv[i], "fanout") == 0);
+			if(!opt.fanout_order && strcmp(argv[i], "inputs") != 0) {
+				opt.bad = true;
+			}
+		}
+		else if(strcmp(argv[i], "--stats") == 0) {
+			opt.stats = true;
+		}
+		else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			i++;
+			opt.json = (strcmp(argv[i], "json") == 0);
+			if(!opt.json && strcmp(argv[i], "csv") != 0) {
+				opt.bad = true;
+			}
+			opt.format_set = true;
+		}
+		else if(strcmp(argv[i], "--vectors") == 0 && i + 1 < argc) {
+			opt.vectors = argv[++i];
+		}
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			opt.threads = atoi(argv[++i]);
+			opt.threads_set = true;
+		}
+		else {
+			argv[1 + opt.num_paths++] = argv[i]; //Gathers the file names after argv[0]
+		}
+	}
+	opt.paths = argv + 1;
+	opt.circuit = (opt.num_paths > 0 && (opt.num_paths <= 2 || opt.mode == MODE_SERVE)) ? argv[1] : NULL;
+	opt.stimulus = (opt.num_paths > 1) ? argv[2] : NULL;
+	if(!validOptions(&opt)) {
+		fprintf(stderr, "usage: %s [--flatten] [--threads T] [--level-parallel | --threaded | --work-stealing | --tiled | --cofactor | --cofactor-bits K | --support] [--stats] [-o F] [--range S:E] [--shard K/N] [--checkpoint F] [--gray-order inputs|fanout] [--ternary] [--cycles N [--streams K] | --faults | --activity [--format csv|json] | --timing [--delays F] [--format csv|json] | --support-tables | --analyze | --serve PATH | --monte-carlo N [--seed S] [--dump F] [--format csv|json]] [--vectors F] <circuit> [stimulus | circuit...]\n", argv[0]);
+		return 1;
+	}
+	struct dls_circuit* c = loadCircuit(opt.circuit, &opt);
+	if(c == NULL) {
+		return 1;
+	}
+	int ret;
+	switch(opt.mode) {
+		case MODE_CYCLES:
+			ret = runCycles(c, &opt);
+			break;
+		case MODE_FAULTS:
+			ret = runFaults(c, &opt);
+			break;
+		case MODE_ACTIVITY:
+			ret = runActivity(c, &opt);
+			break;
+		case MODE_MONTECARLO:
+			ret = runMonteCarlo(c, &opt);
+			break;
+		case MODE_TIMING:
+			ret = runTiming(c, &opt);
+			break;
+		case MODE_SUPPORT:
+			ret = runSupportTables(c, &opt);
+			break;
+		case MODE_ANALYZE:
+			ret = runAnalyze(c, &opt);
+			break;
+		case MODE_SERVE:
+			ret = runServe(c, &opt);
+			break;
+		default:
+			if(opt.output != NULL) {
+				ret = runMappedTable(c, &opt);
+			}
+			else if(opt.ternary) {
+				ret = runTernaryTable(c, &opt);
+			}
+			else if(opt.cofactor_bits >= -1) {
+				ret = runCofactor(c, &opt);
+			}
+			else if(opt.work_stealing) {
+				ret = runScheduled(c, &opt);
+			}
+			else if(opt.tiled) {
+				ret = runTiled(c, &opt);
+			}
+			else {
+				ret = runTruthTable(c, &opt);
+			}
+			break;
+	}
+	dlsFree(c);
+	return ret;
+}
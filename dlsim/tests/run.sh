@@ -0,0 +1,107 @@
+#!/bin/sh
+#
+# Regression tests of dlsim, run by make check
+#
+# Runs every line of cases and compares what dlsim prints with the files in
+# expected/, then checks the outputs dlsim writes to files: -o, --dump and the
+# resume of --checkpoint
+# With --update, rewrites the expected files from the first case naming each, and
+# still checks the other cases against them
+#
+cd "$(dirname "$0")" || exit 1
+DLSIM=../dlsim
+update=false
+if [ "$1" = "--update" ]; then
+	update=true
+	rm -f expected/*
+fi
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+passed=0
+failed=0
+
+fail() {
+	echo "FAIL: $*"
+	failed=$((failed + 1))
+}
+
+# same file expected: passes when dlsim wrote what expected/ holds
+same() {
+	if $update && [ ! -e "expected/$2" ]; then
+		cp "$1" "expected/$2"
+	fi
+	if cmp -s "$1" "expected/$2"; then
+		passed=$((passed + 1))
+		return 0
+	else
+		fail "output differs from expected/$2"
+		diff "expected/$2" "$1" | head -5
+		return 1
+	fi
+}
+
+while read -r expected status args; do
+	case "$expected" in
+		""|"#"*) continue ;;
+	esac
+	$DLSIM $args > "$tmp/out" 2> "$tmp/err" < /dev/null
+	rc=$?
+	if [ "$rc" -ne "$status" ]; then
+		fail "dlsim $args: exit status $rc, expected $status"
+		head -3 "$tmp/err"
+		continue
+	fi
+	case "$expected" in
+		-)
+			if [ -s "$tmp/out" ]; then
+				fail "dlsim $args: printed output"
+			else
+				passed=$((passed + 1))
+			fi ;;
+		*.err) same "$tmp/err" "$expected" || echo "    from dlsim $args" ;;
+		*) same "$tmp/out" "$expected" || echo "    from dlsim $args" ;;
+	esac
+done < cases
+
+# -o writes the table into a file from several threads
+for engine in "" --support; do
+	rm -f "$tmp/table"
+	if $DLSIM -o "$tmp/table" --threads 3 $engine ../../bench/mul6.v; then
+		same "$tmp/table" mul6.table || echo "    from dlsim -o $engine"
+	else
+		fail "dlsim -o $engine failed"
+	fi
+done
+
+# --dump writes the rows of the random vectors it reports on
+if $DLSIM --monte-carlo 200 --seed 3 --dump "$tmp/dump" ../../bench/c17.v > "$tmp/out"; then
+	same "$tmp/out" c17.montecarlo
+	same "$tmp/dump" c17.dump
+else
+	fail "dlsim --monte-carlo --dump failed"
+fi
+
+# --checkpoint resumes after a header, truncating only the rows past the checkpoint,
+# and refuses other output files and other circuits
+ck="$tmp/ckpt"
+printf 'header\n' > "$tmp/want"
+cat expected/mul6.table >> "$tmp/want"
+printf 'header\n' > "$tmp/out"
+$DLSIM --checkpoint "$ck" ../../bench/mul6.v >> "$tmp/out" && cmp -s "$tmp/out" "$tmp/want" \
+	&& passed=$((passed + 1)) || fail "--checkpoint run after a header"
+printf 'partial row\n' >> "$tmp/out"
+awk '{$3 = 1024; print}' "$ck" > "$ck.new" && mv "$ck.new" "$ck"
+$DLSIM --checkpoint "$ck" ../../bench/mul6.v >> "$tmp/out" && cmp -s "$tmp/out" "$tmp/want" \
+	&& passed=$((passed + 1)) || fail "--checkpoint resume from row 1024"
+cp "$tmp/want" "$tmp/other"
+printf 'more\n' >> "$tmp/other"
+cp "$tmp/other" "$tmp/other.before"
+! $DLSIM --checkpoint "$ck" ../../bench/mul6.v >> "$tmp/other" 2> /dev/null && cmp -s "$tmp/other" "$tmp/other.before" \
+	&& passed=$((passed + 1)) || fail "--checkpoint resume into another file"
+cp ../../bench/mul6.v "$tmp/mul6.v"
+printf '// changed\n' >> "$tmp/mul6.v"
+! $DLSIM --checkpoint "$ck" "$tmp/mul6.v" >> "$tmp/out" 2> /dev/null && cmp -s "$tmp/out" "$tmp/want" \
+	&& passed=$((passed + 1)) || fail "--checkpoint resume of another circuit"
+
+echo "$passed passed, $failed failed"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,337 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Netlist analysis
+ *
+ * Counts that describe a compiled circuit without simulating it: gates per type,
+ * the width of every level, the fanout histogram, the support and cone of every
+ * output, the fanout cone of every input, and a longest path. Each is one pass over
+ * the gates or pins, except the supports, one bitset of inputs per net, and the
+ * cones, one marked walk per output or input.
+ */
+
+/*
+ * Structure: ranked
+ *
+ * An input and the size of its fanout cone, for sorting
+ *
+ */
+struct ranked {
+	int cone;
+	int input;
+};
+
+/*
+ * Function: countFanout
+ *
+ * Fills the fanout histogram from the pins of the gates and flip-flops
+ *
+ * returns: DLS_OK, or DLS_ERR_NOMEM
+ */
+static int countFanout(const struct dls_circuit* c, struct dls_analysis* a) {
+	int* reads = calloc(c->num_nets, sizeof(int));
+	if(reads == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		int fanin = gateNumFanin(&c->gates[g]);
+		for(int f = 0; f < fanin; f++) {
+			reads[gateFanin(&c->gates[g], f)]++;
+		}
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		reads[c->regs[r].d]++;
+		if(c->regs[r].rst != -1) {
+			reads[c->regs[r].rst]++;
+		}
+	}
+	for(int slot = 0; slot < c->num_nets; slot++) {
+		if(c->slot_net[slot] > NET_ONE && reads[slot] > a->max_fanout) {
+			a->max_fanout = reads[slot];
+		}
+	}
+	a->fanout = calloc(a->max_fanout + 1, sizeof(int));
+	for(int slot = 0; a->fanout != NULL && slot < c->num_nets; slot++) {
+		if(c->slot_net[slot] > NET_ONE) {
+			a->fanout[reads[slot]]++;
+		}
+	}
+	free(reads);
+	return (a->fanout == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+}
+
+/*
+ * Function: countCones
+ *
+ * Fills the support and cone size of every output
+ *
+ * driver: Gate driving each slot, -1 for inputs, flip-flops and constants
+ *
+ * returns: DLS_OK, or DLS_ERR_NOMEM
+ */
+static int countCones(const struct dls_circuit* c, const int* driver, struct dls_analysis* a) {
+	int words = (c->num_inputs + 63)/64 + 1;
+	uint64_t* sup = collectSupports(c, words);
+	int* stamp = malloc((c->num_gates + 1)*sizeof(int));
+	int* stack = malloc((c->num_gates + 1)*sizeof(int));
+	a->support = calloc(c->num_outputs + 1, sizeof(int));
+	a->cone = calloc(c->num_outputs + 1, sizeof(int));
+	if(sup == NULL || stamp == NULL || stack == NULL || a->support == NULL || a->cone == NULL) {
+		free(sup);
+		free(stamp);
+		free(stack);
+		return DLS_ERR_NOMEM;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		stamp[g] = -1;
+	}
+	for(int o = 0; o < c->num_outputs; o++) {
+		const uint64_t* bits = &sup[(size_t)c->outputs[o]*words];
+		for(int w = 0; w < words; w++) {
+			a->support[o] += __builtin_popcountll(bits[w]);
+		}
+		int top = 0;
+		if(driver[c->outputs[o]] >= 0) {
+			stamp[driver[c->outputs[o]]] = o;
+			stack[top++] = driver[c->outputs[o]];
+		}
+		while(top > 0) {
+			const struct gate* g = &c->gates[stack[--top]];
+			a->cone[o]++;
+			int fanin = gateNumFanin(g);
+			for(int f = 0; f < fanin; f++) {
+				int d = driver[gateFanin(g, f)];
+				if(d >= 0 && stamp[d] != o) {
+					stamp[d] = o;
+					stack[top++] = d;
+				}
+			}
+		}
+	}
+	free(sup);
+	free(stamp);
+	free(stack);
+	return DLS_OK;
+}
+
+/*
+ * Function: inputCones
+ *
+ * Counts the gates in the fanout cone of every input
+ *
+ * cone: Filled with one count per input
+ *
+ * returns: DLS_OK, or DLS_ERR_NOMEM
+ */
+static int inputCones(const struct dls_circuit* c, int* cone) {
+	int* fan_start = calloc(c->num_nets + 1, sizeof(int));
+	int* fan_gate = malloc(((size_t)c->num_pins + 1)*sizeof(int));
+	int* stamp = malloc((c->num_gates + 1)*sizeof(int));
+	int* stack = malloc(((size_t)c->num_pins + c->num_inputs + 1)*sizeof(int));
+	if(fan_start == NULL || fan_gate == NULL || stamp == NULL || stack == NULL) {
+		free(fan_start);
+		free(fan_gate);
+		free(stamp);
+		free(stack);
+		return DLS_ERR_NOMEM;
+	}
+	/*Gates reading each slot, as runs of fan_gate: counted, summed into the end of each
+	run, then filled backwards so that fan_start[slot] ends at the start of its run*/
+	for(int g = 0; g < c->num_gates; g++) {
+		int fanin = gateNumFanin(&c->gates[g]);
+		for(int f = 0; f < fanin; f++) {
+			fan_start[gateFanin(&c->gates[g], f)]++;
+		}
+		stamp[g] = -1;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		fan_start[i + 1] += fan_start[i];
+	}
+	for(int g = c->num_gates - 1; g >= 0; g--) {
+		int fanin = gateNumFanin(&c->gates[g]);
+		for(int f = fanin - 1; f >= 0; f--) {
+			fan_gate[--fan_start[gateFanin(&c->gates[g], f)]] = g;
+		}
+	}
+	for(int i = 0; i < c->num_inputs; i++) {
+		cone[i] = 0;
+		int top = 0;
+		stack[top++] = c->inputs[i];
+		while(top > 0) {
+			int slot = stack[--top];
+			for(int f = fan_start[slot]; f < fan_start[slot + 1]; f++) {
+				const struct gate* g = &c->gates[fan_gate[f]];
+				if(stamp[fan_gate[f]] == i) {
+					continue;
+				}
+				stamp[fan_gate[f]] = i;
+				cone[i]++;
+				for(int o = 0; o < g->num_outputs; o++) {
+					stack[top++] = g->outputs[o];
+				}
+			}
+		}
+	}
+	free(fan_start);
+	free(fan_gate);
+	free(stamp);
+	free(stack);
+	return DLS_OK;
+}
+
+/*
+ * Function: compareRanked
+ *
+ * qsort comparison putting larger cones first, then the INPUTVAR order
+ *
+ */
+static int compareRanked(const void* a, const void* b) {
+	const struct ranked* x = a;
+	const struct ranked* y = b;
+	if(x->cone != y->cone) {
+		return (x->cone < y->cone) - (x->cone > y->cone);
+	}
+	return (x->input > y->input) - (x->input < y->input);
+}
+
+/*
+ * Function: dlsFanoutOrder
+ *
+ * Orders the inputs for dlsSetSweepOrder so that the inputs with the smallest fanout
+ * cones take the gray code bits that change most often, which lowers the number of
+ * gates an incremental sweep re-evaluates
+ *
+ * order: Filled with the input indices, largest cone first
+ *
+ * returns: DLS_OK, DLS_ERR_STATE if the circuit is not compiled, or DLS_ERR_NOMEM
+ */
+int dlsFanoutOrder(const struct dls_circuit* c, int* order) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	int* cone = malloc((c->num_inputs + 1)*sizeof(int));
+	struct ranked* r = malloc((c->num_inputs + 1)*sizeof(struct ranked));
+	int rc = (cone == NULL || r == NULL) ? DLS_ERR_NOMEM : inputCones(c, cone);
+	if(rc == DLS_OK) {
+		for(int i = 0; i < c->num_inputs; i++) {
+			r[i].cone = cone[i];
+			r[i].input = i;
+		}
+		qsort(r, c->num_inputs, sizeof(struct ranked), compareRanked);
+		for(int i = 0; i < c->num_inputs; i++) {
+			order[i] = r[i].input;
+		}
+	}
+	free(cone);
+	free(r);
+	return rc;
+}
+
+/*
+ * Function: findPath
+ *
+ * Fills a longest path: the deepest output or flip-flop input, then back through a
+ * fanin one level lower at every gate
+ *
+ * returns: DLS_OK, or DLS_ERR_NOMEM
+ */
+static int findPath(const struct dls_circuit* c, const int* driver, struct dls_analysis* a) {
+	int end = -1;
+	int depth = -1;
+	for(int k = 0; k < c->num_outputs + c->num_regs; k++) {
+		int slot = (k < c->num_outputs) ? c->outputs[k] : c->regs[k - c->num_outputs].d;
+		int level = (driver[slot] >= 0) ? c->gates[driver[slot]].level : 0;
+		if(level > depth) {
+			depth = level;
+			end = slot;
+		}
+	}
+	a->path_length = (depth > 0) ? depth : 0;
+	a->path = malloc((a->path_length + 1)*sizeof(int));
+	if(a->path == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	if(end < 0) {
+		a->path_length = -1; //No output or flip-flop, so no path
+		return DLS_OK;
+	}
+	for(int k = a->path_length; k >= 0; k--) {
+		a->path[k] = c->slot_net[end];
+		if(k == 0) {
+			break;
+		}
+		const struct gate* g = &c->gates[driver[end]];
+		int fanin = gateNumFanin(g);
+		for(int f = 0; f < fanin; f++) {
+			int slot = gateFanin(g, f);
+			int level = (driver[slot] >= 0) ? c->gates[driver[slot]].level : 0;
+			if(level == g->level - 1) {
+				end = slot;
+				break;
+			}
+		}
+	}
+	return DLS_OK;
+}
+
+/*
+ * Function: dlsAnalyze
+ *
+ * Describes the shape of a compiled circuit; instances count as one gate of
+ * type INST, as they are evaluated
+ *
+ * a: Filled in, to be released with dlsAnalysisFree even on error
+ *
+ * returns: DLS_OK, DLS_ERR_STATE if the circuit is not compiled, or DLS_ERR_NOMEM
+ */
+int dlsAnalyze(const struct dls_circuit* c, struct dls_analysis* a) {
+	memset(a, 0, sizeof(struct dls_analysis));
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	a->num_levels = c->num_levels;
+	a->level_width = calloc(c->num_levels + 1, sizeof(int));
+	int* driver = malloc((c->num_nets + 1)*sizeof(int));
+	if(a->level_width == NULL || driver == NULL) {
+		free(driver);
+		return DLS_ERR_NOMEM;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		driver[i] = -1;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		const struct gate* gt = &c->gates[g];
+		a->gate_types[gt->oper]++;
+		if(gt->level >= 1) {
+			a->level_width[gt->level - 1]++;
+		}
+		for(int o = 0; o < gt->num_outputs; o++) {
+			driver[gt->outputs[o]] = g;
+		}
+	}
+	int rc = countFanout(c, a);
+	if(rc == DLS_OK) {
+		rc = countCones(c, driver, a);
+	}
+	if(rc == DLS_OK) {
+		rc = findPath(c, driver, a);
+	}
+	if(rc == DLS_OK) {
+		a->input_cone = malloc((c->num_inputs + 1)*sizeof(int));
+		rc = (a->input_cone == NULL) ? DLS_ERR_NOMEM : inputCones(c, a->input_cone);
+	}
+	free(driver);
+	return rc;
+}
+
+void dlsAnalysisFree(struct dls_analysis* a) {
+	free(a->level_width);
+	free(a->fanout);
+	free(a->support);
+	free(a->cone);
+	free(a->input_cone);
+	free(a->path);
+	memset(a, 0, sizeof(struct dls_analysis));
+}
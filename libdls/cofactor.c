@@ -0,0 +1,481 @@
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include "dls_internal.h"
+
+/*
+ * Cofactor splitting
+ *
+ * Fixing the inputs on the k most significant bits of the sweep, the first k inputs
+ * unless dlsSetSweepOrder chose otherwise, splits it into 2^k cofactors, and since
+ * row r applies gray(r), the top k bits of every row of block j are gray(j): each
+ * cofactor is one contiguous run of 2^(n-k) rows. With those inputs known, many
+ * nets are constants. They are found with the three-valued evaluator, the other
+ * inputs set to X, for 64 cofactors per pass. Gates whose outputs are constant,
+ * or that only feed constants, are dropped, and the constants they would have
+ * produced are written into the state once per cofactor. Every cofactor is then a
+ * task sweeping its rows with its own reduced gate list.
+ */
+
+/*Cofactors are at least 2^MIN_SUBSPACE rows, so that reducing costs little next to sweeping*/
+#define MIN_SUBSPACE 10
+
+/*And at most 2^MAX_SUBSPACE rows, which bounds the output buffered per task*/
+#define MAX_SUBSPACE 20
+
+/*Cost of reducing a cofactor, in gate evaluations per gate of the circuit*/
+#define REDUCE_COST 4
+
+/*Finished tasks waiting to be emitted, per thread*/
+#define WINDOW_PER_THREAD 2
+
+/*
+ * Structure: constant
+ *
+ * A slot a reduced gate list reads but no longer computes, and its value
+ *
+ */
+struct constant {
+	int slot;
+	uint64_t word;
+};
+
+/*
+ * Structure: reduction
+ *
+ * The gates left in one cofactor
+ *
+ * gates: Gate indices in level order
+ *
+ * consts: Slots to set once before sweeping
+ *
+ * mark: Per gate, 1 if it is in gates
+ *
+ */
+struct reduction {
+	int* gates;
+	int num_gates;
+	struct constant* consts;
+	int num_consts;
+	char* mark;
+};
+
+/*
+ * Structure: cofslot
+ *
+ * A task's place in the emit window
+ *
+ */
+struct cofslot {
+	uint64_t* out;
+	uint64_t first;
+	uint64_t count;
+	bool done;
+};
+
+/*
+ * Structure: cofjob
+ *
+ * Everything shared by the workers of one dlsCofactorRun call
+ *
+ * driver: Gate driving each slot, -1 for inputs, flip-flops and constants
+ *
+ * next: Next task to start; task t is cofactor task0 + t
+ *
+ * emitted: Tasks handed to emit, a task starts only once it fits in the window
+ *
+ */
+struct cofjob {
+	const struct dls_circuit* circuit;
+	int bits;
+	int* driver;
+	uint64_t first;
+	uint64_t end;
+	uint64_t task0;
+	uint64_t num_tasks;
+	uint64_t next;
+	uint64_t emitted;
+	struct cofslot* slots;
+	int window;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	pthread_cond_t finished;
+	uint64_t sum_gates;
+	int min_gates;
+	int max_gates;
+};
+
+/*
+ * Structure: cofworker
+ *
+ * Arguments of one worker thread
+ *
+ */
+struct cofworker {
+	struct cofjob* job;
+	struct dls_state* state;
+	struct dls_xstate* xstate;
+	struct reduction red;
+	pthread_t tid;
+};
+
+/*
+ * Function: analyze
+ *
+ * Evaluates the circuit in three-valued logic with the inputs on the top k bits of
+ * the sweep set to the bits of codes[L] in lane L, and the others X
+ * Flip-flops are 0, as in the truth table
+ *
+ */
+static void analyze(const struct dls_circuit* c, struct dls_xstate* xs, int k, const uint64_t* codes, int lanes) {
+	for(int j = 0; j < c->num_inputs; j++) {
+		int b = sweepBit(c, j) - (c->num_inputs - k); //Bit of the cofactor code, negative if not fixed
+		uint64_t value = 0;
+		for(int l = 0; b >= 0 && l < lanes; l++) {
+			value |= ((codes[l] >> b) & 1) << l;
+		}
+		dlsXSetInput(xs, j, value, (b >= 0) ? 0 : ~(uint64_t)0);
+	}
+	dlsXResetRegisters(xs);
+	dlsXEvalWords(c, xs);
+}
+
+/*
+ * Function: slotConstant
+ *
+ * returns: 1 if a slot is known in a lane of analyze, with its value in *value, else 0
+ */
+static int slotConstant(const struct dls_circuit* c, const struct dls_xstate* xs, int slot, int lane, int* value) {
+	uint64_t v, x;
+	dlsXGetNet(xs, c->slot_net[slot], &v, &x);
+	*value = (v >> lane) & 1;
+	return !((x >> lane) & 1);
+}
+
+/*
+ * Function: reduce
+ *
+ * Builds the gate list of one lane of analyze: the gates that some non-constant
+ * output needs through non-constant nets, and the constants they read
+ *
+ * consts: False to only list the gates
+ *
+ */
+static void reduce(const struct dls_circuit* c, const struct dls_xstate* xs, const int* driver, int lane, struct reduction* red, bool consts) {
+	int value;
+	memset(red->mark, 0, c->num_gates);
+	for(int o = 0; o < c->num_outputs; o++) {
+		int d = driver[c->outputs[o]];
+		if(d >= 0 && !slotConstant(c, xs, c->outputs[o], lane, &value)) {
+			red->mark[d] = 1;
+		}
+	}
+	for(int k = c->num_gates - 1; k >= 0; k--) { //Drivers come earlier in the level order
+		const struct gate* g = &c->gates[c->order[k]];
+		if(!red->mark[c->order[k]]) {
+			continue;
+		}
+		int fanin = gateNumFanin(g);
+		for(int f = 0; f < fanin; f++) {
+			int slot = gateFanin(g, f);
+			if(driver[slot] >= 0 && !slotConstant(c, xs, slot, lane, &value)) {
+				red->mark[driver[slot]] = 1;
+			}
+		}
+	}
+	red->num_gates = 0;
+	red->num_consts = 0;
+	for(int k = 0; k < c->num_gates; k++) {
+		int gi = c->order[k];
+		if(!red->mark[gi]) {
+			continue;
+		}
+		red->gates[red->num_gates++] = gi;
+		const struct gate* g = &c->gates[gi];
+		int fanin = gateNumFanin(g);
+		for(int f = 0; consts && f < fanin; f++) {
+			int slot = gateFanin(g, f);
+			if(driver[slot] >= 0 && !red->mark[driver[slot]] && slotConstant(c, xs, slot, lane, &value)) {
+				red->consts[red->num_consts].slot = slot;
+				red->consts[red->num_consts++].word = value ? ~(uint64_t)0 : 0;
+			}
+		}
+	}
+	for(int o = 0; consts && o < c->num_outputs; o++) {
+		int slot = c->outputs[o];
+		if(driver[slot] >= 0 && !red->mark[driver[slot]] && slotConstant(c, xs, slot, lane, &value)) {
+			red->consts[red->num_consts].slot = slot;
+			red->consts[red->num_consts++].word = value ? ~(uint64_t)0 : 0;
+		}
+	}
+}
+
+/*
+ * Function: allocReduction
+ *
+ * returns: DLS_OK, or DLS_ERR_NOMEM
+ */
+static int allocReduction(const struct dls_circuit* c, struct reduction* red) {
+	red->gates = malloc((c->num_gates + 1)*sizeof(int));
+	red->consts = malloc(((size_t)c->num_pins + c->num_outputs + 1)*sizeof(struct constant));
+	red->mark = malloc(c->num_gates + 1);
+	return (red->gates == NULL || red->consts == NULL || red->mark == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+}
+
+static void freeReduction(struct reduction* red) {
+	free(red->gates);
+	free(red->consts);
+	free(red->mark);
+}
+
+/*
+ * Function: chooseBits
+ *
+ * Picks the number of fixed inputs with the lowest estimated time: for every k
+ * allowed, up to 64 evenly spaced cofactors are reduced to measure the mean gate
+ * count, and the cofactors are assumed to be shared out evenly among the threads
+ *
+ * returns: The number of inputs to fix
+ */
+static int chooseBits(const struct dls_circuit* c, struct dls_xstate* xs, const int* driver, struct reduction* red, int threads) {
+	int n = c->num_inputs;
+	int lo = (n > MAX_SUBSPACE) ? n - MAX_SUBSPACE : 0;
+	int hi = (n - MIN_SUBSPACE > lo) ? n - MIN_SUBSPACE : lo;
+	int best = lo;
+	double best_time = 0;
+	for(int k = lo; k <= hi; k++) {
+		uint64_t cofactors = (uint64_t)1 << k;
+		int lanes = (cofactors < 64) ? (int)cofactors : 64;
+		uint64_t codes[64];
+		for(int l = 0; l < lanes; l++) {
+			uint64_t j = (cofactors/lanes)*l;
+			codes[l] = j ^ (j >> 1);
+		}
+		analyze(c, xs, k, codes, lanes);
+		double gates = 0;
+		for(int l = 0; l < lanes; l++) {
+			reduce(c, xs, driver, l, red, false);
+			gates += red->num_gates;
+		}
+		gates /= lanes;
+		double rounds = (double)((cofactors + threads - 1)/threads);
+		double time = rounds*((double)((uint64_t)1 << (n - k))/64*gates + REDUCE_COST*(double)c->num_gates);
+		if(k == lo || time < best_time) {
+			best = k;
+			best_time = time;
+		}
+	}
+	return best;
+}
+
+/*
+ * Function: runTask
+ *
+ * Reduces one cofactor and sweeps its rows into the task's slot
+ *
+ */
+static void runTask(struct cofworker* w, uint64_t t) {
+	struct cofjob* job = w->job;
+	const struct dls_circuit* c = job->circuit;
+	int m = c->num_inputs - job->bits;
+	uint64_t j = job->task0 + t;
+	uint64_t code = j ^ (j >> 1);
+	analyze(c, w->xstate, job->bits, &code, 1);
+	reduce(c, w->xstate, job->driver, 0, &w->red, true);
+	struct cofslot* slot = &job->slots[t % job->window];
+	uint64_t first = j << m;
+	uint64_t end = first + ((uint64_t)1 << m);
+	slot->first = (first > job->first) ? first : job->first;
+	slot->count = ((end < job->end) ? end : job->end) - slot->first;
+	uint64_t* v = w->state->nets;
+	memset(v, 0, c->num_words*sizeof(uint64_t)); //Wide decoders only clear what they set, so start from all 0
+	v[NET_ONE] = ~(uint64_t)0;
+	for(int i = 0; i < w->red.num_consts; i++) {
+		v[w->red.consts[i].slot] = w->red.consts[i].word;
+	}
+	for(uint64_t word = 0; word*64 < slot->count; word++) {
+		dlsSetGrayInputs(w->state, slot->first + word*64);
+		for(int k = 0; k < w->red.num_gates; k++) {
+			const struct gate* g = &c->gates[w->red.gates[k]];
+			if(g->oper == OP_INSTANCE) {
+				evalInstance(g, v, w->state->subs);
+			}
+			else {
+				evalGate(g, v, w->state->scratch);
+			}
+		}
+		for(int o = 0; o < c->num_outputs; o++) {
+			slot->out[word*c->num_outputs + o] = v[c->outputs[o]];
+		}
+	}
+}
+
+/*
+ * Function: cofactorWorker
+ *
+ * Worker thread: runs tasks in order while they fit in the emit window
+ *
+ */
+static void* cofactorWorker(void* arg) {
+	struct cofworker* w = arg;
+	struct cofjob* job = w->job;
+	pthread_mutex_lock(&job->lock);
+	for(;;) {
+		while(job->next < job->num_tasks && job->next >= job->emitted + job->window) {
+			pthread_cond_wait(&job->ready, &job->lock);
+		}
+		if(job->next >= job->num_tasks) {
+			break;
+		}
+		uint64_t t = job->next++;
+		pthread_mutex_unlock(&job->lock);
+		runTask(w, t);
+		pthread_mutex_lock(&job->lock);
+		job->slots[t % job->window].done = true;
+		job->sum_gates += w->red.num_gates;
+		if(w->red.num_gates < job->min_gates) {
+			job->min_gates = w->red.num_gates;
+		}
+		if(w->red.num_gates > job->max_gates) {
+			job->max_gates = w->red.num_gates;
+		}
+		pthread_cond_signal(&job->finished);
+	}
+	pthread_mutex_unlock(&job->lock);
+	return NULL;
+}
+
+/*
+ * Function: dlsCofactorRun
+ *
+ * Evaluates rows of the gray code sweep cofactor by cofactor on worker threads
+ * Outputs are passed to emit in row order, from the calling thread, one call
+ * per cofactor
+ *
+ * c: The compiled circuit
+ *
+ * bits: Number of inputs to fix, those on the top bits of the sweep, or -1 to choose it from the
+ *	estimated gate reduction; unless 0, every cofactor must be at least 2^10 rows, since
+ *	cofactors are swept from their first row in whole words of 64
+ *
+ * first: Index of the first row, a multiple of 64
+ *
+ * count: Number of rows
+ *
+ * threads: Number of worker threads, 0 for one per online processor
+ *
+ * emit: Called with the index of the cofactor's first row, its number of rows and
+ *	the output words, word w of output o at out[w*dlsNumOutputs + o]
+ *
+ * ctx: Passed to emit
+ *
+ * stats: NULL, or filled with the chosen split and the gates left per cofactor
+ *
+ * returns: DLS_OK, DLS_ERR_STATE, DLS_ERR_ARG if the rows are not in the sweep or
+ *	a cofactor would be under 2^10 or over 2^20 rows, or DLS_ERR_NOMEM
+ */
+int dlsCofactorRun(const struct dls_circuit* c, int bits, uint64_t first, uint64_t count, int threads,
+		void (*emit)(void*, uint64_t, uint64_t, const uint64_t*), void* ctx, struct dls_cofactor_stats* stats) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	int n = c->num_inputs;
+	if(n > 63 || first % 64 != 0 || first > ((uint64_t)1 << n) || count > ((uint64_t)1 << n) - first ||
+			bits > n || (bits >= 0 && n - bits > MAX_SUBSPACE) || (bits > 0 && n - bits < MIN_SUBSPACE)) {
+		return DLS_ERR_ARG;
+	}
+	struct cofjob job;
+	memset(&job, 0, sizeof(job));
+	job.circuit = c;
+	job.first = first;
+	job.end = first + count;
+	job.min_gates = c->num_gates;
+	threads = dlsSchedThreads(threads);
+	job.window = WINDOW_PER_THREAD*threads;
+	job.driver = malloc((c->num_nets + 1)*sizeof(int));
+	job.slots = calloc(job.window, sizeof(struct cofslot));
+	struct cofworker* workers = calloc(threads, sizeof(struct cofworker));
+	int rc = (job.driver == NULL || job.slots == NULL || workers == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+	for(int i = 0; rc == DLS_OK && i < c->num_nets; i++) {
+		job.driver[i] = -1;
+	}
+	for(int g = 0; rc == DLS_OK && g < c->num_gates; g++) {
+		for(int o = 0; o < c->gates[g].num_outputs; o++) {
+			job.driver[c->gates[g].outputs[o]] = g;
+		}
+	}
+	for(int t = 0; rc == DLS_OK && t < threads; t++) {
+		workers[t].job = &job;
+		workers[t].state = dlsStateNew(c);
+		workers[t].xstate = dlsXStateNew(c);
+		if(workers[t].state == NULL || workers[t].xstate == NULL || allocReduction(c, &workers[t].red) != DLS_OK) {
+			rc = DLS_ERR_NOMEM;
+		}
+	}
+	job.bits = (rc == DLS_OK && bits < 0) ? chooseBits(c, workers[0].xstate, job.driver, &workers[0].red, threads) : bits;
+	int m = n - job.bits;
+	if(rc == DLS_OK && count > 0) {
+		job.task0 = first >> m;
+		job.num_tasks = ((job.end - 1) >> m) - job.task0 + 1;
+	}
+	size_t task_words = ((((uint64_t)1 << m) + 63)/64)*c->num_outputs + 1;
+	for(int i = 0; rc == DLS_OK && i < job.window; i++) {
+		job.slots[i].out = malloc(task_words*sizeof(uint64_t));
+		if(job.slots[i].out == NULL) {
+			rc = DLS_ERR_NOMEM;
+		}
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.ready, NULL);
+	pthread_cond_init(&job.finished, NULL);
+	int started = 0;
+	for(int t = 0; rc == DLS_OK && t < threads; t++) {
+		if(pthread_create(&workers[t].tid, NULL, cofactorWorker, &workers[t]) != 0) {
+			break;
+		}
+		started++;
+	}
+	if(rc == DLS_OK && started == 0) {
+		rc = DLS_ERR_NOMEM;
+	}
+	for(uint64_t t = 0; rc == DLS_OK && t < job.num_tasks; t++) {
+		struct cofslot* slot = &job.slots[t % job.window];
+		pthread_mutex_lock(&job.lock);
+		while(!slot->done) {
+			pthread_cond_wait(&job.finished, &job.lock);
+		}
+		pthread_mutex_unlock(&job.lock);
+		emit(ctx, slot->first, slot->count, slot->out);
+		pthread_mutex_lock(&job.lock);
+		slot->done = false;
+		job.emitted++;
+		pthread_cond_broadcast(&job.ready);
+		pthread_mutex_unlock(&job.lock);
+	}
+	for(int t = 0; t < started; t++) {
+		pthread_join(workers[t].tid, NULL);
+	}
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.ready);
+	pthread_cond_destroy(&job.finished);
+	if(stats != NULL) {
+		stats->bits = job.bits;
+		stats->cofactors = job.num_tasks;
+		stats->gates = c->num_gates;
+		stats->min_gates = (job.num_tasks > 0) ? job.min_gates : 0;
+		stats->max_gates = job.max_gates;
+		stats->mean_gates = (job.num_tasks > 0) ? (double)job.sum_gates/job.num_tasks : 0;
+	}
+	for(int t = 0; workers != NULL && t < threads; t++) {
+		dlsStateFree(workers[t].state);
+		dlsXStateFree(workers[t].xstate);
+		freeReduction(&workers[t].red);
+	}
+	for(int i = 0; job.slots != NULL && i < job.window; i++) {
+		free(job.slots[i].out);
+	}
+	free(workers);
+	free(job.slots);
+	free(job.driver);
+	return rc;
+}
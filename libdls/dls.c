@@ -0,0 +1,1537 @@
+#include<stdlib.h>
+#include<stdio.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Structure: lexer
+ *
+ * Cursor over a netlist held in memory, splitting it into whitespace separated tokens
+ *
+ */
+struct lexer {
+	const char* p;
+	const char* end;
+};
+
+/*
+ * Structure: gatedef
+ *
+ * Keyword table for the fixed arity gates
+ *
+ */
+struct gatedef {
+	const char* keyword;
+	int oper;
+	int num_inputs;
+};
+
+static const struct gatedef fixedGates[] = {
+	{"NOT", OP_NOT, 1},
+	{"AND", OP_AND, 2},
+	{"OR", OP_OR, 2},
+	{"NAND", OP_NAND, 2},
+	{"NOR", OP_NOR, 2},
+	{"XOR", OP_XOR, 2},
+	{"XNOR", OP_XNOR, 2},
+};
+
+/*Largest decoder or multiplexer select count accepted by the parser, also used by first and second*/
+#define MAX_SELECTS 24
+
+/*
+ * Function: nextToken
+ *
+ * Advances the lexer to the next token
+ *
+ * lx: The lexer
+ *
+ * tok: Set to the start of the token
+ *
+ * len: Set to the length of the token
+ *
+ * returns: true if a token was found, false at the end of the buffer
+ */
+static bool nextToken(struct lexer* lx, const char** tok, size_t* len) {
+	while(lx->p < lx->end && (*lx->p == ' ' || *lx->p == '\t' || *lx->p == '\n' || *lx->p == '\r')) {
+		lx->p++;
+	}
+	if(lx->p == lx->end) {
+		return false;
+	}
+	*tok = lx->p;
+	while(lx->p < lx->end && *lx->p != ' ' && *lx->p != '\t' && *lx->p != '\n' && *lx->p != '\r') {
+		lx->p++;
+	}
+	*len = lx->p - *tok;
+	return true;
+}
+
+/*
+ * Function: tokenIs
+ *
+ * Compares a token against a NUL terminated keyword
+ *
+ */
+bool tokenIs(const char* tok, size_t len, const char* keyword) {
+	return strlen(keyword) == len && memcmp(tok, keyword, len) == 0;
+}
+
+/*
+ * Function: nextCount
+ *
+ * Reads a non-negative decimal count
+ *
+ * returns: The count, or -1 if the next token is missing or not a number
+ */
+static int nextCount(struct lexer* lx) {
+	const char* tok;
+	size_t len;
+	if(!nextToken(lx, &tok, &len) || len > 9) {
+		return -1;
+	}
+	int ret = 0;
+	for(size_t i = 0; i < len; i++) {
+		if(tok[i] < '0' || tok[i] > '9') {
+			return -1;
+		}
+		ret = ret*10 + (tok[i] - '0');
+	}
+	return ret;
+}
+
+/*
+ * Function: hashName
+ *
+ * FNV-1a hash of a net name
+ *
+ */
+static uint32_t hashName(const char* name, size_t len) {
+	uint32_t h = 2166136261u;
+	for(size_t i = 0; i < len; i++) {
+		h ^= (unsigned char)name[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/*
+ * Function: lookup
+ *
+ * Searches the symbol table for a net
+ *
+ * returns: The net id, or -1 if the net does not exist
+ */
+static int lookup(const struct dls_circuit* c, const char* name, size_t len) {
+	int id = c->buckets[hashName(name, len) & (c->num_buckets - 1)];
+	while(id != -1) {
+		if(c->name_start[id + 1] - c->name_start[id] == len + 1 && memcmp(netName(c, id), name, len) == 0) {
+			return id;
+		}
+		id = c->chain[id];
+	}
+	return -1;
+}
+
+/*
+ * Function: rehash
+ *
+ * Doubles the number of hash buckets and relinks every net
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int rehash(struct dls_circuit* c) {
+	int n = c->num_buckets*2;
+	int* buckets = malloc(n*sizeof(int));
+	if(buckets == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	for(int i = 0; i < n; i++) {
+		buckets[i] = -1;
+	}
+	for(int id = 0; id < c->num_nets; id++) {
+		uint32_t b = hashName(netName(c, id), c->name_start[id + 1] - c->name_start[id] - 1) & (n - 1);
+		c->chain[id] = buckets[b];
+		buckets[b] = id;
+	}
+	free(c->buckets);
+	c->buckets = buckets;
+	c->num_buckets = n;
+	return DLS_OK;
+}
+
+/*
+ * Function: intern
+ *
+ * Finds a net by name, creating it if it does not exist yet
+ *
+ * returns: The net id, or DLS_ERR_NOMEM
+ */
+int intern(struct dls_circuit* c, const char* name, size_t len) {
+	int id = lookup(c, name, len);
+	if(id != -1) {
+		return id;
+	}
+	if(c->num_nets == c->cap_nets) {
+		int cap = c->cap_nets*2;
+		size_t* name_start = realloc(c->name_start, (cap + 1)*sizeof(size_t));
+		if(name_start == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		c->name_start = name_start;
+		int* chain = realloc(c->chain, cap*sizeof(int));
+		if(chain == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		c->chain = chain;
+		c->cap_nets = cap;
+	}
+	size_t used = c->name_start[c->num_nets];
+	if(used + len + 1 > c->pool_cap) {
+		size_t cap = c->pool_cap*2;
+		while(cap < used + len + 1) {
+			cap *= 2;
+		}
+		char* pool = realloc(c->name_pool, cap);
+		if(pool == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		c->name_pool = pool;
+		c->pool_cap = cap;
+	}
+	memcpy(c->name_pool + used, name, len);
+	c->name_pool[used + len] = '\0';
+	id = c->num_nets++;
+	c->name_start[c->num_nets] = used + len + 1;
+	uint32_t b = hashName(name, len) & (c->num_buckets - 1);
+	c->chain[id] = c->buckets[b];
+	c->buckets[b] = id;
+	if(c->num_nets > c->num_buckets) {
+		if(rehash(c) != DLS_OK) {
+			return DLS_ERR_NOMEM;
+		}
+	}
+	return id;
+}
+
+/*
+ * Function: readNets
+ *
+ * Reads a list of net names and converts them to ids
+ *
+ * ids: Array of at least count ints to fill
+ *
+ * count: Number of names to read
+ *
+ * returns: DLS_OK, DLS_ERR_SYNTAX if the list is cut short, or DLS_ERR_NOMEM
+ */
+static int readNets(struct dls_circuit* c, struct lexer* lx, int* ids, int count) {
+	const char* tok;
+	size_t len;
+	for(int i = 0; i < count; i++) {
+		if(!nextToken(lx, &tok, &len)) {
+			return DLS_ERR_SYNTAX;
+		}
+		int id = intern(c, tok, len);
+		if(id < 0) {
+			return id;
+		}
+		ids[i] = id;
+	}
+	return DLS_OK;
+}
+
+/*
+ * Function: linkPins
+ *
+ * Points a gate's inputs, multi and outputs into the shared pins array
+ *
+ */
+void linkPins(struct dls_circuit* c, struct gate* g) {
+	g->inputs = c->pins + g->pin;
+	g->multi = NULL;
+	g->outputs = g->inputs + g->num_inputs;
+	if(g->oper == OP_MULTIPLEXER) {
+		g->multi = g->outputs;
+		g->outputs = g->multi + (1 << g->num_inputs);
+	}
+}
+
+/*
+ * Function: newGate
+ *
+ * Appends an empty gate and reserves pins for its nets
+ *
+ * returns: The new gate, or NULL if out of memory
+ */
+struct gate* newGate(struct dls_circuit* c, int oper, int num_inputs, int num_outputs) {
+	if(c->num_gates == c->cap_gates) {
+		int cap = c->cap_gates*2;
+		struct gate* gates = realloc(c->gates, cap*sizeof(struct gate));
+		if(gates == NULL) {
+			return NULL;
+		}
+		c->gates = gates;
+		c->cap_gates = cap;
+	}
+	int num_pins = num_inputs + num_outputs + (oper == OP_MULTIPLEXER ? (1 << num_inputs) : 0);
+	if(c->num_pins + num_pins > c->cap_pins) {
+		int cap = c->cap_pins*2;
+		while(cap < c->num_pins + num_pins) {
+			cap *= 2;
+		}
+		int* pins = realloc(c->pins, cap*sizeof(int));
+		if(pins == NULL) {
+			return NULL;
+		}
+		c->pins = pins;
+		c->cap_pins = cap;
+		for(int i = 0; i < c->num_gates; i++) { //The array may have moved
+			linkPins(c, &c->gates[i]);
+		}
+	}
+	struct gate* g = &c->gates[c->num_gates++];
+	g->oper = oper;
+	g->num_inputs = num_inputs;
+	g->num_outputs = num_outputs;
+	g->pin = c->num_pins;
+	g->level = 0;
+	g->sub = NULL;
+	g->inst = -1;
+	g->hot = -1;
+	c->num_pins += num_pins;
+	linkPins(c, g);
+	return g;
+}
+
+/*
+ * Function: newReg
+ *
+ * Appends a flip-flop without reset
+ *
+ * returns: The new flip-flop, or NULL if out of memory
+ */
+struct reg* newReg(struct dls_circuit* c) {
+	if(c->num_regs == c->cap_regs) {
+		int cap = c->cap_regs ? c->cap_regs*2 : 16;
+		struct reg* regs = realloc(c->regs, cap*sizeof(struct reg));
+		if(regs == NULL) {
+			return NULL;
+		}
+		c->regs = regs;
+		c->cap_regs = cap;
+	}
+	struct reg* r = &c->regs[c->num_regs++];
+	r->rst = -1;
+	return r;
+}
+
+/*
+ * Function: variadicCount
+ *
+ * Recognizes the variadic form "AND n a1 ... an out" of a two input gate
+ * The count must be at least 2 and be followed by exactly n+1 names on the same line,
+ * so the two input form "AND a b out" keeps its meaning even when a is the constant 1
+ *
+ * returns: The count, consumed from the lexer, or -1 for the two input form
+ */
+static int variadicCount(struct lexer* lx) {
+	struct lexer peek = *lx;
+	int n = nextCount(&peek);
+	if(n < 2) {
+		return -1;
+	}
+	int names = 0;
+	const char* p = peek.p;
+	while(p < peek.end && *p != '\n') {
+		while(p < peek.end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+			p++;
+		}
+		if(p == peek.end || *p == '\n') {
+			break;
+		}
+		names++;
+		while(p < peek.end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+			p++;
+		}
+	}
+	if(names != n + 1) {
+		return -1;
+	}
+	*lx = peek;
+	return n;
+}
+
+/*
+ * Function: parseVarList
+ *
+ * Parses the arguments of INPUTVAR or OUTPUTVAR
+ *
+ * list: Set to the array of net ids
+ *
+ * count: Set to the number of nets
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseVarList(struct dls_circuit* c, struct lexer* lx, int** list, int* count) {
+	if(*list != NULL) { //Declared twice
+		return DLS_ERR_SYNTAX;
+	}
+	int n = nextCount(lx);
+	if(n < 0) {
+		return DLS_ERR_SYNTAX;
+	}
+	*list = malloc((n + 1)*sizeof(int));
+	if(*list == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	*count = n;
+	return readNets(c, lx, *list, n);
+}
+
+/*
+ * Function: parseGate
+ *
+ * Parses the arguments of one gate keyword and appends the gate
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseGate(struct dls_circuit* c, struct lexer* lx, const char* tok, size_t len) {
+	for(size_t i = 0; i < sizeof(fixedGates)/sizeof(fixedGates[0]); i++) {
+		if(tokenIs(tok, len, fixedGates[i].keyword)) {
+			int n = fixedGates[i].num_inputs;
+			if(n == 2) {
+				int count = variadicCount(lx);
+				if(count != -1) {
+					n = count;
+				}
+			}
+			struct gate* g = newGate(c, fixedGates[i].oper, n, 1);
+			if(g == NULL) {
+				return DLS_ERR_NOMEM;
+			}
+			int rc = readNets(c, lx, g->inputs, g->num_inputs);
+			if(rc != DLS_OK) {
+				return rc;
+			}
+			return readNets(c, lx, g->outputs, 1);
+		}
+	}
+	if(tokenIs(tok, len, "DFF") || tokenIs(tok, len, "DFFR")) {
+		struct reg* r = newReg(c);
+		if(r == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		int rc = readNets(c, lx, &r->d, 1);
+		if(rc == DLS_OK && len == 4) { //DFFR d rst q
+			rc = readNets(c, lx, &r->rst, 1);
+		}
+		if(rc != DLS_OK) {
+			return rc;
+		}
+		return readNets(c, lx, &r->q, 1);
+	}
+	if(tokenIs(tok, len, "DECODER")) {
+		int n = nextCount(lx);
+		if(n < 0 || n > MAX_SELECTS) {
+			return DLS_ERR_SYNTAX;
+		}
+		struct gate* g = newGate(c, OP_DECODER, n, 1 << n);
+		if(g == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		int rc = readNets(c, lx, g->inputs, n);
+		if(rc != DLS_OK) {
+			return rc;
+		}
+		return readNets(c, lx, g->outputs, 1 << n);
+	}
+	if(tokenIs(tok, len, "MULTIPLEXER")) {
+		int m = nextCount(lx);
+		if(m <= 0 || (m & (m - 1)) != 0) { //Encoding count must be a power of two
+			return DLS_ERR_SYNTAX;
+		}
+		int n = 0;
+		while((1 << n) < m) {
+			n++;
+		}
+		if(n > MAX_SELECTS) {
+			return DLS_ERR_SYNTAX;
+		}
+		struct gate* g = newGate(c, OP_MULTIPLEXER, n, 1);
+		if(g == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		int rc = readNets(c, lx, g->multi, m);
+		if(rc != DLS_OK) {
+			return rc;
+		}
+		rc = readNets(c, lx, g->inputs, n);
+		if(rc != DLS_OK) {
+			return rc;
+		}
+		return readNets(c, lx, g->outputs, 1);
+	}
+	return DLS_ERR_SYNTAX;
+}
+
+/*
+ * Function: newCircuit
+ *
+ * Allocates an empty circuit holding only the constant nets
+ *
+ * returns: The circuit, or NULL if out of memory
+ */
+struct dls_circuit* newCircuit(void) {
+	struct dls_circuit* c = calloc(1, sizeof(struct dls_circuit));
+	if(c == NULL) {
+		return NULL;
+	}
+	c->cap_nets = 64;
+	c->name_start = malloc((c->cap_nets + 1)*sizeof(size_t));
+	c->chain = malloc(c->cap_nets*sizeof(int));
+	c->pool_cap = 1024;
+	c->name_pool = malloc(c->pool_cap);
+	c->num_buckets = 64;
+	c->buckets = malloc(c->num_buckets*sizeof(int));
+	c->cap_gates = 64;
+	c->gates = malloc(c->cap_gates*sizeof(struct gate));
+	c->module_index = -1;
+	c->cap_pins = 256;
+	c->pins = malloc(c->cap_pins*sizeof(int));
+	if(c->name_start == NULL || c->name_pool == NULL || c->chain == NULL || c->buckets == NULL || c->gates == NULL || c->pins == NULL) {
+		dlsFree(c);
+		return NULL;
+	}
+	c->name_start[0] = 0;
+	for(int i = 0; i < c->num_buckets; i++) {
+		c->buckets[i] = -1;
+	}
+	if(intern(c, "0", 1) != NET_ZERO || intern(c, "1", 1) != NET_ONE) {
+		dlsFree(c);
+		return NULL;
+	}
+	return c;
+}
+
+/*
+ * Function: newInstName
+ *
+ * Stores the name of an instance
+ *
+ * returns: The index of the name in inst_names, or DLS_ERR_NOMEM
+ */
+int newInstName(struct dls_circuit* c, const char* name, size_t len) {
+	if(c->num_insts == c->cap_insts) {
+		int cap = c->cap_insts ? c->cap_insts*2 : 16;
+		char** names = realloc(c->inst_names, cap*sizeof(char*));
+		if(names == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		c->inst_names = names;
+		c->cap_insts = cap;
+	}
+	char* copy = malloc(len + 1);
+	if(copy == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	memcpy(copy, name, len);
+	copy[len] = '\0';
+	c->inst_names[c->num_insts] = copy;
+	return c->num_insts++;
+}
+
+/*
+ * Function: parseInstance
+ *
+ * Parses "INST module name n1 ... nk", binding the nets in order to the module's
+ * INPUTVAR then OUTPUTVAR lists
+ *
+ * top: The top level circuit holding the module templates
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseInstance(struct dls_circuit* c, struct lexer* lx, struct dls_circuit* top) {
+	const char* tok;
+	size_t len;
+	if(!nextToken(lx, &tok, &len)) {
+		return DLS_ERR_SYNTAX;
+	}
+	struct dls_circuit* m = NULL;
+	for(int i = 0; i < top->num_modules; i++) {
+		if(tokenIs(tok, len, top->modules[i]->name)) {
+			m = top->modules[i];
+		}
+	}
+	if(m == NULL || !nextToken(lx, &tok, &len)) { //Modules are defined before use
+		return DLS_ERR_SYNTAX;
+	}
+	int inst = newInstName(c, tok, len);
+	if(inst < 0) {
+		return inst;
+	}
+	struct gate* g = newGate(c, OP_INSTANCE, m->num_inputs, m->num_outputs);
+	if(g == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	g->sub = m;
+	g->inst = inst;
+	if(m->has_regs) {
+		c->has_regs = true;
+	}
+	return readNets(c, lx, g->inputs, m->num_inputs + m->num_outputs);
+}
+
+static int parseBody(struct dls_circuit*, struct lexer*, struct dls_circuit*, bool*);
+
+/*
+ * Function: parseModule
+ *
+ * Parses "MODULE name" up to the matching ENDMODULE into a new template,
+ * and compiles the template once for all of its instances
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseModule(struct dls_circuit* top, struct lexer* lx) {
+	const char* tok;
+	size_t len;
+	if(!nextToken(lx, &tok, &len)) {
+		return DLS_ERR_SYNTAX;
+	}
+	if(top->num_modules == top->cap_modules) {
+		int cap = top->cap_modules ? top->cap_modules*2 : 8;
+		struct dls_circuit** modules = realloc(top->modules, cap*sizeof(struct dls_circuit*));
+		if(modules == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		top->modules = modules;
+		top->cap_modules = cap;
+	}
+	struct dls_circuit* m = newCircuit();
+	if(m == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	m->name = malloc(len + 1);
+	if(m->name == NULL) {
+		dlsFree(m);
+		return DLS_ERR_NOMEM;
+	}
+	memcpy(m->name, tok, len);
+	m->name[len] = '\0';
+	m->module_index = top->num_modules;
+	top->modules[top->num_modules++] = m;
+	bool ended = false;
+	int rc = parseBody(m, lx, top, &ended);
+	if(rc != DLS_OK) {
+		return rc;
+	}
+	if(!ended || m->inputs == NULL || m->outputs == NULL) {
+		return DLS_ERR_SYNTAX;
+	}
+	if(m->num_regs > 0) {
+		m->has_regs = true;
+	}
+	return dlsCompile(m);
+}
+
+/*
+ * Function: parseBody
+ *
+ * Parses statements into a circuit until the end of the buffer, or until
+ * ENDMODULE when the circuit is a module template
+ *
+ * top: The top level circuit, where modules are defined and looked up
+ *
+ * ended: Set to true if parsing stopped at ENDMODULE
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseBody(struct dls_circuit* c, struct lexer* lx, struct dls_circuit* top, bool* ended) {
+	const char* tok;
+	size_t toklen;
+	int rc = DLS_OK;
+	while(rc == DLS_OK && nextToken(lx, &tok, &toklen)) {
+		if(tokenIs(tok, toklen, "INPUTVAR")) {
+			rc = parseVarList(c, lx, &c->inputs, &c->num_inputs);
+		}
+		else if(tokenIs(tok, toklen, "OUTPUTVAR")) {
+			rc = parseVarList(c, lx, &c->outputs, &c->num_outputs);
+		}
+		else if(tokenIs(tok, toklen, "INST")) {
+			rc = parseInstance(c, lx, top);
+		}
+		else if(tokenIs(tok, toklen, "MODULE")) {
+			rc = (c == top) ? parseModule(top, lx) : DLS_ERR_SYNTAX; //No nested definitions
+		}
+		else if(tokenIs(tok, toklen, "ENDMODULE")) {
+			if(c == top) {
+				return DLS_ERR_SYNTAX;
+			}
+			*ended = true;
+			return DLS_OK;
+		}
+		else {
+			rc = parseGate(c, lx, tok, toklen);
+		}
+	}
+	return rc;
+}
+
+/*
+ * Function: dlsLoadBuffer
+ *
+ * Parses a circuit description held in memory
+ * INPUTVAR and OUTPUTVAR may appear anywhere in the description, as in second
+ *
+ * AND, OR, NAND, NOR, XOR and XNOR also take any number of inputs, written
+ *	AND n a1 ... an out
+ * on one line, like the count of a DECODER
+ *
+ * Besides the gates of second, flip-flops are written
+ *	DFF d q
+ *	DFFR d rst q
+ * with a synchronous active high reset for DFFR
+ *
+ * Reusable subcircuits are defined with their own INPUTVAR and OUTPUTVAR ports
+ *	MODULE name
+ *	...
+ *	ENDMODULE
+ * and instantiated after their definition with
+ *	INST name instance n1 ... nk
+ * where the nets bind to the module's inputs, then its outputs
+ *
+ * out: Set to the loaded circuit on success, NULL otherwise
+ *
+ * buf: The circuit description, need not be NUL terminated
+ *
+ * len: Length of buf in bytes
+ *
+ * returns: DLS_OK or an error code
+ */
+int dlsLoadBuffer(struct dls_circuit** out, const char* buf, size_t len) {
+	*out = NULL;
+	struct dls_circuit* c = newCircuit();
+	if(c == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	struct lexer lx = {buf, buf + len};
+	bool ended = false;
+	int rc = parseBody(c, &lx, c, &ended);
+	if(rc == DLS_OK && (c->inputs == NULL || c->outputs == NULL)) {
+		rc = DLS_ERR_SYNTAX;
+	}
+	if(rc != DLS_OK) {
+		dlsFree(c);
+		return rc;
+	}
+	*out = c;
+	return DLS_OK;
+}
+
+/*
+ * Function: dlsLoadFile
+ *
+ * Reads a circuit description file and parses it with dlsLoadBlif if its name
+ * ends in .blif, dlsLoadVerilog if it ends in .v, and dlsLoadBuffer otherwise
+ *
+ * out: Set to the loaded circuit on success, NULL otherwise
+ *
+ * path: Path of the file
+ *
+ * returns: DLS_OK or an error code
+ */
+int dlsLoadFile(struct dls_circuit** out, const char* path) {
+	*out = NULL;
+	FILE* datafile = fopen(path, "rb");
+	if(datafile == NULL) {
+		return DLS_ERR_IO;
+	}
+	size_t cap = 1 << 16;
+	size_t len = 0;
+	char* buf = malloc(cap);
+	size_t n;
+	while(buf != NULL && (n = fread(buf + len, 1, cap - len, datafile)) > 0) {
+		len += n;
+		if(len == cap) {
+			cap *= 2;
+			char* grown = realloc(buf, cap);
+			if(grown == NULL) {
+				free(buf);
+			}
+			buf = grown;
+		}
+	}
+	bool failed = ferror(datafile);
+	fclose(datafile);
+	if(buf == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	if(failed) {
+		free(buf);
+		return DLS_ERR_IO;
+	}
+	size_t plen = strlen(path);
+	int rc;
+	if(plen >= 5 && strcmp(path + plen - 5, ".blif") == 0) {
+		rc = dlsLoadBlif(out, buf, len);
+	}
+	else if(plen >= 2 && strcmp(path + plen - 2, ".v") == 0) {
+		rc = dlsLoadVerilog(out, buf, len);
+	}
+	else {
+		rc = dlsLoadBuffer(out, buf, len);
+	}
+	free(buf);
+	return rc;
+}
+
+/*
+ * Function: gateFanin
+ *
+ * Lists every net a gate reads, including multiplexer encodings
+ *
+ * g: The gate
+ *
+ * i: Index of the fanin, from 0 to gateNumFanin(g)-1
+ *
+ * returns: The net id
+ */
+int gateNumFanin(const struct gate* g) {
+	return g->num_inputs + (g->oper == OP_MULTIPLEXER ? (1 << g->num_inputs) : 0);
+}
+
+int gateFanin(const struct gate* g, int i) {
+	if(i < g->num_inputs) {
+		return g->inputs[i];
+	}
+	return g->multi[i - g->num_inputs];
+}
+
+/*
+ * Function: dlsCompile
+ *
+ * Checks that every net has exactly one source and levelizes the gates
+ * Replaces the repeated scans of second with a single pass over the fanout lists,
+ * and reports combinational loops instead of spinning on them
+ * Flip-flop outputs are sources like the primary inputs, so loops through a
+ * flip-flop are allowed
+ * Instances of modules holding flip-flops are flattened first; other instances
+ * stay references to their template unless dlsFlatten was called
+ *
+ * c: The loaded circuit
+ *
+ * returns: DLS_OK, DLS_ERR_UNDRIVEN, DLS_ERR_MULTIDRIVEN, DLS_ERR_CYCLE or DLS_ERR_NOMEM
+ */
+int dlsCompile(struct dls_circuit* c) {
+	if(c == NULL) {
+		return DLS_ERR_ARG;
+	}
+	if(c->compiled) {
+		return DLS_OK;
+	}
+	int rc = DLS_OK;
+	if(c->has_regs && c->num_insts > 0) { //Flip-flops need a copy per instance
+		rc = flattenInstances(c, true);
+		if(rc != DLS_OK) {
+			return rc;
+		}
+	}
+	int* driver = malloc(c->num_nets*sizeof(int)); //Gate driving each net, -1 undriven, -2 source
+	int* pending = calloc(c->num_gates + 1, sizeof(int)); //Fanins still waiting on a gate
+	int* fanout_start = calloc(c->num_nets + 1, sizeof(int));
+	int* fanout = NULL;
+	int* queue = malloc((c->num_gates + 1)*sizeof(int));
+	int* order = malloc((c->num_gates + 1)*sizeof(int));
+	if(driver == NULL || pending == NULL || fanout_start == NULL || queue == NULL || order == NULL) {
+		rc = DLS_ERR_NOMEM;
+		goto done;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		driver[i] = -1;
+	}
+	driver[NET_ZERO] = -2;
+	driver[NET_ONE] = -2;
+	for(int i = 0; i < c->num_inputs; i++) {
+		driver[c->inputs[i]] = -2;
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		if(driver[c->regs[r].q] != -1) {
+			rc = DLS_ERR_MULTIDRIVEN;
+			goto done;
+		}
+		driver[c->regs[r].q] = -2;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		for(int k = 0; k < c->gates[g].num_outputs; k++) {
+			int net = c->gates[g].outputs[k];
+			if(driver[net] != -1) {
+				rc = DLS_ERR_MULTIDRIVEN;
+				goto done;
+			}
+			driver[net] = g;
+		}
+	}
+	for(int i = 0; i < c->num_outputs; i++) {
+		if(driver[c->outputs[i]] == -1) {
+			rc = DLS_ERR_UNDRIVEN;
+			goto done;
+		}
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		if(driver[c->regs[r].d] == -1 || (c->regs[r].rst != -1 && driver[c->regs[r].rst] == -1)) {
+			rc = DLS_ERR_UNDRIVEN;
+			goto done;
+		}
+	}
+	/*Count fanouts per net, then fill them in*/
+	int edges = 0;
+	for(int g = 0; g < c->num_gates; g++) {
+		int n = gateNumFanin(&c->gates[g]);
+		for(int k = 0; k < n; k++) {
+			int net = gateFanin(&c->gates[g], k);
+			if(driver[net] == -1) {
+				rc = DLS_ERR_UNDRIVEN;
+				goto done;
+			}
+			if(driver[net] >= 0) {
+				fanout_start[net + 1]++;
+				pending[g]++;
+				edges++;
+			}
+		}
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		fanout_start[i + 1] += fanout_start[i];
+	}
+	fanout = malloc((edges + 1)*sizeof(int));
+	if(fanout == NULL) {
+		rc = DLS_ERR_NOMEM;
+		goto done;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		int n = gateNumFanin(&c->gates[g]);
+		for(int k = 0; k < n; k++) {
+			int net = gateFanin(&c->gates[g], k);
+			if(driver[net] >= 0) {
+				fanout[fanout_start[net]++] = g;
+			}
+		}
+	}
+	for(int i = c->num_nets; i > 0; i--) { //Shift starts back after filling
+		fanout_start[i] = fanout_start[i - 1];
+	}
+	fanout_start[0] = 0;
+	/*Kahn's algorithm, level is one more than the deepest driver*/
+	int qhead = 0;
+	int qtail = 0;
+	for(int g = 0; g < c->num_gates; g++) {
+		c->gates[g].level = 1;
+		if(pending[g] == 0) {
+			queue[qtail++] = g;
+		}
+	}
+	while(qhead < qtail) {
+		struct gate* g = &c->gates[queue[qhead++]];
+		for(int k = 0; k < g->num_outputs; k++) {
+			int net = g->outputs[k];
+			for(int f = fanout_start[net]; f < fanout_start[net + 1]; f++) {
+				struct gate* h = &c->gates[fanout[f]];
+				if(h->level < g->level + 1) {
+					h->level = g->level + 1;
+				}
+				if(--pending[fanout[f]] == 0) {
+					queue[qtail++] = fanout[f];
+				}
+			}
+		}
+	}
+	if(qtail != c->num_gates) {
+		rc = DLS_ERR_CYCLE;
+		goto done;
+	}
+	/*Counting sort by level, stable so gates keep file order within a level*/
+	int num_levels = 0;
+	for(int g = 0; g < c->num_gates; g++) {
+		if(c->gates[g].level > num_levels) {
+			num_levels = c->gates[g].level;
+		}
+	}
+	int* level_start = calloc(num_levels + 2, sizeof(int));
+	if(level_start == NULL) {
+		rc = DLS_ERR_NOMEM;
+		goto done;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		level_start[c->gates[g].level]++;
+	}
+	for(int l = 1; l <= num_levels + 1; l++) {
+		level_start[l] += level_start[l - 1];
+	}
+	for(int g = c->num_gates - 1; g >= 0; g--) {
+		order[--level_start[c->gates[g].level]] = g;
+	}
+	/*level_start[l] now holds the first slot of level l; shift so level_start[l-1] does*/
+	for(int l = 0; l <= num_levels; l++) {
+		level_start[l] = level_start[l + 1];
+	}
+	level_start[num_levels + 1] = c->num_gates;
+	c->scratch_words = 1;
+	c->num_words = c->num_nets;
+	for(int g = 0; g < c->num_gates; g++) {
+		struct gate* gt = &c->gates[g];
+		if(gt->oper == OP_DECODER && gt->num_inputs > SPARSE_SELECTS) {
+			gt->hot = c->num_words;
+			c->num_words += 64;
+		}
+		else if((gt->oper == OP_DECODER || gt->oper == OP_MULTIPLEXER) && (1 << gt->num_inputs) > c->scratch_words) {
+			c->scratch_words = 1 << gt->num_inputs;
+		}
+	}
+	c->order = order;
+	order = NULL;
+	c->level_start = level_start;
+	c->num_levels = num_levels;
+	rc = layoutCircuit(c);
+	c->compiled = (rc == DLS_OK);
+done:
+	free(driver);
+	free(pending);
+	free(fanout_start);
+	free(fanout);
+	free(queue);
+	free(order);
+	return rc;
+}
+
+/*
+ * Function: dlsFree
+ *
+ * Releases a circuit and everything it owns
+ *
+ */
+void dlsFree(struct dls_circuit* c) {
+	if(c == NULL) {
+		return;
+	}
+	free(c->name_pool);
+	free(c->name_start);
+	free(c->sweep_bit);
+	free(c->bit_input);
+	free(c->chain);
+	free(c->buckets);
+	free(c->gates);
+	free(c->pins);
+	free(c->inputs);
+	free(c->outputs);
+	free(c->regs);
+	for(int i = 0; i < c->num_modules; i++) {
+		dlsFree(c->modules[i]);
+	}
+	free(c->modules);
+	for(int i = 0; i < c->num_insts; i++) {
+		free(c->inst_names[i]);
+	}
+	free(c->inst_names);
+	free(c->name);
+	free(c->order);
+	free(c->level_start);
+	free(c->net_slot);
+	free(c->slot_net);
+	free(c);
+}
+
+/*
+ * Function: dlsErrorString
+ *
+ * returns: A readable description of a return code
+ */
+const char* dlsErrorString(int code) {
+	switch(code) {
+		case DLS_OK: return "success";
+		case DLS_ERR_NOMEM: return "out of memory";
+		case DLS_ERR_IO: return "cannot read file";
+		case DLS_ERR_SYNTAX: return "syntax error in circuit description";
+		case DLS_ERR_UNDRIVEN: return "net has no driver";
+		case DLS_ERR_CYCLE: return "combinational loop";
+		case DLS_ERR_MULTIDRIVEN: return "net has more than one driver";
+		case DLS_ERR_STATE: return "circuit is not compiled";
+		case DLS_ERR_ARG: return "invalid argument";
+	}
+	return "unknown error";
+}
+
+/*
+ * Function: dlsGateTypeName
+ *
+ * returns: The keyword of a gate type, 0 to DLS_GATE_TYPES-1, or NULL
+ */
+const char* dlsGateTypeName(int type) {
+	static const char* const names[DLS_GATE_TYPES] = {
+		"NOT", "AND", "OR", "NAND", "NOR", "XOR", "XNOR", "DECODER", "MULTIPLEXER", "INST"
+	};
+	return (type >= 0 && type < DLS_GATE_TYPES) ? names[type] : NULL;
+}
+
+/*
+ * Functions: Circuit queries
+ *
+ * Counts and names of the inputs, outputs and nets of a loaded circuit
+ * Input and output indices follow the INPUTVAR and OUTPUTVAR order
+ */
+
+int dlsNumInputs(const struct dls_circuit* c) {
+	return c->num_inputs;
+}
+
+int dlsNumOutputs(const struct dls_circuit* c) {
+	return c->num_outputs;
+}
+
+int dlsNumNets(const struct dls_circuit* c) {
+	return c->num_nets;
+}
+
+int dlsNumGates(const struct dls_circuit* c) {
+	return c->num_gates;
+}
+
+const char* dlsInputName(const struct dls_circuit* c, int i) {
+	return netName(c, slotNet(c, c->inputs[i]));
+}
+
+const char* dlsOutputName(const struct dls_circuit* c, int i) {
+	return netName(c, slotNet(c, c->outputs[i]));
+}
+
+const char* dlsNetName(const struct dls_circuit* c, int net) {
+	return netName(c, net);
+}
+
+int dlsFindNet(const struct dls_circuit* c, const char* name) {
+	return lookup(c, name, strlen(name));
+}
+
+/*
+ * Function: dlsStateNew
+ *
+ * Allocates the evaluation state for a compiled circuit
+ * A state must only be used by one thread at a time
+ * All nets, including the flip-flops, start at 0
+ *
+ * returns: The state, or NULL if out of memory or the circuit is not compiled
+ */
+struct dls_state* dlsStateNew(const struct dls_circuit* c) {
+	if(c == NULL || !c->compiled) {
+		return NULL;
+	}
+	struct dls_state* s = malloc(sizeof(struct dls_state));
+	if(s == NULL) {
+		return NULL;
+	}
+	s->circuit = c;
+	s->nets = calloc(c->num_words, sizeof(uint64_t));
+	s->scratch = malloc(c->scratch_words*sizeof(uint64_t));
+	s->latch = malloc((c->num_regs + 1)*sizeof(uint64_t));
+	s->num_subs = c->num_modules;
+	s->subs = calloc(c->num_modules + 1, sizeof(struct dls_state*));
+	if(s->nets == NULL || s->scratch == NULL || s->latch == NULL || s->subs == NULL) {
+		dlsStateFree(s);
+		return NULL;
+	}
+	for(int i = 0; i < c->num_modules; i++) {
+		s->subs[i] = dlsStateNew(c->modules[i]);
+		if(s->subs[i] == NULL) {
+			dlsStateFree(s);
+			return NULL;
+		}
+	}
+	s->nets[NET_ONE] = ~(uint64_t)0;
+	return s;
+}
+
+void dlsStateFree(struct dls_state* s) {
+	if(s == NULL) {
+		return;
+	}
+	free(s->nets);
+	free(s->scratch);
+	free(s->latch);
+	if(s->subs != NULL) {
+		for(int i = 0; i < s->num_subs; i++) {
+			dlsStateFree(s->subs[i]);
+		}
+	}
+	free(s->subs);
+	free(s);
+}
+
+/*
+ * Functions: State access
+ *
+ * Sets an input word or reads an input, output or net word of a state
+ * Bit k of each word is the value in the k-th vector
+ */
+
+void dlsSetInput(struct dls_state* s, int i, uint64_t word) {
+	s->nets[s->circuit->inputs[i]] = word;
+}
+
+uint64_t dlsGetInput(const struct dls_state* s, int i) {
+	return s->nets[s->circuit->inputs[i]];
+}
+
+uint64_t dlsGetOutput(const struct dls_state* s, int i) {
+	return s->nets[s->circuit->outputs[i]];
+}
+
+uint64_t dlsGetNet(const struct dls_state* s, int net) {
+	return s->nets[s->circuit->net_slot[net]];
+}
+
+/*
+ * Function: dlsSetGrayInputs
+ *
+ * Loads 64 consecutive rows of the exhaustive sweep into the input words
+ * Row r applies the gray code r^(r>>1), the first input being its most significant bit
+ * unless dlsSetSweepOrder chose another order
+ * Lanes past the last row of the sweep hold rows beyond 2^n and should be ignored
+ *
+ * s: The state
+ *
+ * base: Index of the first row, a multiple of 64
+ *
+ */
+void dlsSetGrayInputs(struct dls_state* s, uint64_t base) {
+	/*Bit k of lanePattern[b] is bit b of k*/
+	static const uint64_t lanePattern[6] = {
+		0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+		0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+	};
+	const struct dls_circuit* c = s->circuit;
+	int n = c->num_inputs;
+	uint64_t gray = base ^ (base >> 1);
+	for(int j = 0; j < n; j++) {
+		int b = sweepBit(c, j);
+		uint64_t word;
+		if(b < 5) {
+			word = lanePattern[b] ^ lanePattern[b + 1];
+		}
+		else if(b == 5) {
+			word = lanePattern[5] ^ (((base >> 6) & 1) ? ~(uint64_t)0 : 0);
+		}
+		else {
+			word = ((gray >> b) & 1) ? ~(uint64_t)0 : 0;
+		}
+		s->nets[c->inputs[j]] = word;
+	}
+}
+
+/*
+ * Function: dlsSetSweepOrder
+ *
+ * Chooses which input each bit of the gray code sweep drives, for dlsSetGrayInputs
+ * and every mode that sweeps; row r then applies gray(r) with order[0] as its most
+ * significant bit, so order[0] changes once and order[n-1] every other row
+ *
+ * order: A permutation of the input indices, or NULL for the INPUTVAR order
+ *
+ * returns: DLS_OK, DLS_ERR_ARG if order is not a permutation, or DLS_ERR_NOMEM
+ */
+int dlsSetSweepOrder(struct dls_circuit* c, const int* order) {
+	free(c->sweep_bit);
+	free(c->bit_input);
+	c->sweep_bit = NULL;
+	c->bit_input = NULL;
+	if(order == NULL) {
+		return DLS_OK;
+	}
+	int n = c->num_inputs;
+	int* sweep_bit = malloc((n + 1)*sizeof(int));
+	int* bit_input = malloc((n + 1)*sizeof(int));
+	if(sweep_bit == NULL || bit_input == NULL) {
+		free(sweep_bit);
+		free(bit_input);
+		return DLS_ERR_NOMEM;
+	}
+	for(int j = 0; j < n; j++) {
+		sweep_bit[j] = -1;
+	}
+	for(int k = 0; k < n; k++) {
+		if(order[k] < 0 || order[k] >= n || sweep_bit[order[k]] != -1) {
+			free(sweep_bit);
+			free(bit_input);
+			return DLS_ERR_ARG;
+		}
+		sweep_bit[order[k]] = n - 1 - k;
+		bit_input[n - 1 - k] = order[k];
+	}
+	c->sweep_bit = sweep_bit;
+	c->bit_input = bit_input;
+	return DLS_OK;
+}
+
+/*
+ * Function: dlsSweepBit
+ *
+ * returns: The bit of the sweep's gray code applied to an input, 0 being the least significant
+ */
+int dlsSweepBit(const struct dls_circuit* c, int input) {
+	return sweepBit(c, input);
+}
+
+/*
+ * Function: grayToBinary64
+ *
+ * Converts gray code to binary, 64 bit version of grayToBinary
+ * Each step folds in twice as many higher bits, so it takes six shifts for any input
+ *
+ */
+uint64_t grayToBinary64(uint64_t in) {
+	in ^= in >> 1;
+	in ^= in >> 2;
+	in ^= in >> 4;
+	in ^= in >> 8;
+	in ^= in >> 16;
+	in ^= in >> 32;
+	return in;
+}
+
+/*
+ * Function: evalDecoder
+ *
+ * Bit-parallel decoder: output l is 1 when the selects, first select most significant,
+ * spell the gray code of l
+ * Builds all 2^n minterms by doubling, so the cost is linear in the number of outputs
+ *
+ */
+static void evalDecoder(const struct gate* g, uint64_t* v, uint64_t* m) {
+	int n = g->num_inputs;
+	m[0] = ~(uint64_t)0;
+	for(int i = 0; i < n; i++) {
+		uint64_t s = v[g->inputs[i]];
+		for(int code = (1 << i) - 1; code >= 0; code--) {
+			uint64_t t = m[code];
+			m[2*code + 1] = t & s;
+			m[2*code] = t & ~s;
+		}
+	}
+	for(int l = 0; l < (1 << n); l++) {
+		v[g->outputs[l]] = m[l ^ (l >> 1)];
+	}
+}
+
+/*
+ * Function: evalWideDecoder
+ *
+ * Decoder with more than SPARSE_SELECTS selects: each lane has exactly one output
+ * at 1, so only the outputs the lanes set last time are cleared before the new
+ * ones are set, instead of building all 2^n minterms
+ *
+ */
+static void evalWideDecoder(const struct gate* g, uint64_t* v) {
+	uint64_t code[64] = {0};
+	uint64_t* hot = &v[g->hot];
+	for(int i = 0; i < g->num_inputs; i++) {
+		uint64_t s = v[g->inputs[i]];
+		for(int k = 0; k < 64; k++) {
+			code[k] = (code[k] << 1) | ((s >> k) & 1);
+		}
+	}
+	for(int k = 0; k < 64; k++) {
+		v[g->outputs[hot[k]]] = 0;
+	}
+	for(int k = 0; k < 64; k++) {
+		hot[k] = grayToBinary64(code[k]);
+		v[g->outputs[hot[k]]] |= (uint64_t)1 << k;
+	}
+}
+
+/*
+ * Function: evalMultiplexer
+ *
+ * Bit-parallel multiplexer: selects the encoding input grayToBinary(selects)
+ * Reduces the encodings pairwise, one select at a time from the least significant
+ *
+ */
+static void evalMultiplexer(const struct gate* g, uint64_t* v, uint64_t* m) {
+	int n = g->num_inputs;
+	int size = 1 << n;
+	for(int code = 0; code < size; code++) {
+		m[code] = v[g->multi[grayToBinary64(code)]];
+	}
+	for(int i = n - 1; i >= 0; i--) {
+		uint64_t s = v[g->inputs[i]];
+		size >>= 1;
+		for(int code = 0; code < size; code++) {
+			m[code] = (m[2*code] & ~s) | (m[2*code + 1] & s);
+		}
+	}
+	v[g->outputs[0]] = m[0];
+}
+
+/*
+ * Functions: reduceAnd, reduceOr, reduceXor
+ *
+ * Combine all inputs of a gate, in one pass over its contiguous fanin
+ *
+ */
+static inline uint64_t reduceAnd(const struct gate* g, const uint64_t* v) {
+	const int* in = g->inputs;
+	uint64_t acc = v[in[0]] & v[in[1]];
+	for(int k = 2; k < g->num_inputs; k++) {
+		acc &= v[in[k]];
+	}
+	return acc;
+}
+
+static inline uint64_t reduceOr(const struct gate* g, const uint64_t* v) {
+	const int* in = g->inputs;
+	uint64_t acc = v[in[0]] | v[in[1]];
+	for(int k = 2; k < g->num_inputs; k++) {
+		acc |= v[in[k]];
+	}
+	return acc;
+}
+
+static inline uint64_t reduceXor(const struct gate* g, const uint64_t* v) {
+	const int* in = g->inputs;
+	uint64_t acc = v[in[0]] ^ v[in[1]];
+	for(int k = 2; k < g->num_inputs; k++) {
+		acc ^= v[in[k]];
+	}
+	return acc;
+}
+
+/*
+ * Function: evalGate
+ *
+ * Evaluates one gate on 64 vectors at once
+ *
+ * g: The gate
+ *
+ * v: Net words
+ *
+ * scratch: At least scratch_words words for decoders and multiplexers
+ *
+ */
+void evalGate(const struct gate* g, uint64_t* v, uint64_t* scratch) {
+	switch(g->oper) {
+		case OP_NOT:
+			v[g->outputs[0]] = ~v[g->inputs[0]];
+			break;
+		case OP_AND:
+			v[g->outputs[0]] = reduceAnd(g, v);
+			break;
+		case OP_OR:
+			v[g->outputs[0]] = reduceOr(g, v);
+			break;
+		case OP_NAND:
+			v[g->outputs[0]] = ~reduceAnd(g, v);
+			break;
+		case OP_NOR:
+			v[g->outputs[0]] = ~reduceOr(g, v);
+			break;
+		case OP_XOR:
+			v[g->outputs[0]] = reduceXor(g, v);
+			break;
+		case OP_XNOR:
+			v[g->outputs[0]] = ~reduceXor(g, v);
+			break;
+		case OP_DECODER:
+			if(g->hot >= 0) {
+				evalWideDecoder(g, v);
+			}
+			else {
+				evalDecoder(g, v, scratch);
+			}
+			break;
+		case OP_MULTIPLEXER:
+			evalMultiplexer(g, v, scratch);
+			break;
+	}
+}
+
+/*
+ * Function: dlsEvalWords
+ *
+ * Evaluates 64 vectors at once
+ * The input words must have been set with dlsSetInput
+ *
+ * c: The compiled circuit
+ *
+ * s: A state created for c
+ *
+ */
+void dlsEvalWords(const struct dls_circuit* c, struct dls_state* s) {
+	evalNets(c, s->nets, s->scratch, s->subs);
+}
+
+/*
+ * Function: evalNets
+ *
+ * Evaluates every gate of a circuit in level order
+ *
+ * v: Net words of the circuit
+ *
+ * scratch: Scratch words of the circuit
+ *
+ * subs: Module states of the top level circuit, for instances
+ *
+ */
+void evalNets(const struct dls_circuit* c, uint64_t* v, uint64_t* scratch, struct dls_state** subs) {
+	for(int k = 0; k < c->num_gates; k++) {
+		const struct gate* g = &c->gates[c->order[k]];
+		if(g->oper == OP_INSTANCE) {
+			evalInstance(g, v, subs);
+		}
+		else {
+			evalGate(g, v, scratch);
+		}
+	}
+}
+
+/*
+ * Function: dlsEval
+ *
+ * Evaluates a batch of vectors into a caller provided buffer
+ *
+ * c: The compiled circuit
+ *
+ * in: count rows of dlsNumInputs bytes, each 0 or 1, in INPUTVAR order
+ *
+ * out: count rows of dlsNumOutputs bytes, filled with 0 or 1 in OUTPUTVAR order
+ *
+ * count: Number of vectors
+ *
+ * returns: DLS_OK, DLS_ERR_STATE if c is not compiled, or DLS_ERR_NOMEM
+ */
+int dlsEval(const struct dls_circuit* c, const unsigned char* in, unsigned char* out, size_t count) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	struct dls_state* s = dlsStateNew(c);
+	if(s == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	int ni = c->num_inputs;
+	int no = c->num_outputs;
+	for(size_t base = 0; base < count; base += 64) {
+		int lanes = (count - base < 64) ? (int)(count - base) : 64;
+		for(int i = 0; i < ni; i++) {
+			uint64_t word = 0;
+			for(int k = 0; k < lanes; k++) {
+				word |= (uint64_t)(in[(base + k)*ni + i] & 1) << k;
+			}
+			s->nets[c->inputs[i]] = word;
+		}
+		dlsEvalWords(c, s);
+		for(int o = 0; o < no; o++) {
+			uint64_t word = s->nets[c->outputs[o]];
+			for(int k = 0; k < lanes; k++) {
+				out[(base + k)*no + o] = (word >> k) & 1;
+			}
+		}
+	}
+	dlsStateFree(s);
+	return DLS_OK;
+}
@@ -0,0 +1,247 @@
+#ifndef DLS_H
+#define DLS_H
+
+#include<stddef.h>
+#include<stdint.h>
+
+/*
+ * libdls: embeddable digital logic simulation library
+ *
+ * The parsing, symbol table, ordering and evaluation code of the first and
+ * second programs, reworked so that every piece of state lives in a circuit
+ * or state object instead of globals. Any number of circuits may be loaded at
+ * once, and one compiled circuit may be evaluated from several threads as long
+ * as each thread uses its own state.
+ *
+ * Typical use:
+ *	struct dls_circuit* c;
+ *	dlsLoadFile(&c, "circuit.txt");
+ *	dlsCompile(c);
+ *	dlsEval(c, in, out, count);
+ *	dlsFree(c);
+ */
+
+/*Return codes*/
+#define DLS_OK 0
+#define DLS_ERR_NOMEM -1
+#define DLS_ERR_IO -2
+#define DLS_ERR_SYNTAX -3
+#define DLS_ERR_UNDRIVEN -4
+#define DLS_ERR_CYCLE -5
+#define DLS_ERR_MULTIDRIVEN -6
+#define DLS_ERR_STATE -7
+#define DLS_ERR_ARG -8
+
+/*Gate types, numbered like the gate_types of dls_analysis and named by dlsGateTypeName*/
+#define DLS_GATE_TYPES 10
+
+/*Byte of an unknown value in the rows of dlsXEval*/
+#define DLS_X 2
+
+struct dls_circuit;
+struct dls_state;
+struct dls_pool;
+struct dls_tiling;
+struct dls_program;
+struct dls_xstate;
+struct dls_timing;
+struct dls_support;
+
+/*
+ * Structure: dls_cofactor_stats
+ *
+ * What dlsCofactorRun did
+ *
+ * bits: Inputs fixed per cofactor
+ *
+ * gates: Gates of the circuit, and the fewest, most and mean left in a cofactor
+ *
+ */
+struct dls_cofactor_stats {
+	int bits;
+	uint64_t cofactors;
+	int gates;
+	int min_gates;
+	int max_gates;
+	double mean_gates;
+};
+
+/*
+ * Structure: dls_analysis
+ *
+ * Shape of a compiled circuit, filled by dlsAnalyze and released by dlsAnalysisFree
+ *
+ * gate_types: Gates of each type, see dlsGateTypeName
+ *
+ * level_width: Gates of each level, from level 1 at level_width[0] to num_levels
+ *
+ * fanout: Nets read by f gate and flip-flop pins at fanout[f], f from 0 to max_fanout,
+ *	the constants 0 and 1 left out
+ *
+ * support, cone: Inputs and gates in the fanin cone of each output
+ *
+ * input_cone: Gates in the fanout cone of each input
+ *
+ * path: Net ids along a longest path, from an input, flip-flop or constant to an
+ *	output or flip-flop input, path_length gates and path_length+1 nets;
+ *	path_length is -1 when there is neither an output nor a flip-flop
+ *
+ */
+struct dls_analysis {
+	int gate_types[DLS_GATE_TYPES];
+	int num_levels;
+	int* level_width;
+	int max_fanout;
+	int* fanout;
+	int* support;
+	int* cone;
+	int* input_cone;
+	int path_length;
+	int* path;
+};
+
+/*
+ * Structure: dls_sched_stats
+ *
+ * Counters of one thread of dlsSchedRun
+ *
+ * tasks: Tasks run, stolen ones included
+ *
+ * steals: Tasks taken from another thread's deque
+ *
+ * busy_seconds: Time spent running tasks
+ *
+ * utilization: busy_seconds over the wall time of the run
+ *
+ */
+struct dls_sched_stats {
+	uint64_t tasks;
+	uint64_t steals;
+	double busy_seconds;
+	double utilization;
+};
+
+/*
+ * Structure: dls_timing_stats
+ *
+ * What dlsTimingSweep measured at one output
+ *
+ * transitions: Changes of the output over the sweep
+ *
+ * glitches: Changes beyond the one, or none, that each transition of the inputs needs
+ *
+ * steps: Input transitions after which the output changed at least once
+ *
+ * max_settle, mean_settle: Latest and mean time of the output's last change after
+ *	those input transitions
+ *
+ */
+struct dls_timing_stats {
+	uint64_t transitions;
+	uint64_t glitches;
+	uint64_t steps;
+	long max_settle;
+	double mean_settle;
+};
+
+int dlsLoadFile(struct dls_circuit**, const char*);
+int dlsLoadBuffer(struct dls_circuit**, const char*, size_t);
+int dlsLoadBlif(struct dls_circuit**, const char*, size_t);
+int dlsLoadVerilog(struct dls_circuit**, const char*, size_t);
+int dlsFlatten(struct dls_circuit*);
+int dlsCompile(struct dls_circuit*);
+void dlsFree(struct dls_circuit*);
+const char* dlsErrorString(int);
+const char* dlsGateTypeName(int);
+int dlsSetSweepOrder(struct dls_circuit*, const int*);
+int dlsSweepBit(const struct dls_circuit*, int);
+
+int dlsNumInputs(const struct dls_circuit*);
+int dlsNumOutputs(const struct dls_circuit*);
+int dlsNumNets(const struct dls_circuit*);
+int dlsNumGates(const struct dls_circuit*);
+const char* dlsInputName(const struct dls_circuit*, int);
+const char* dlsOutputName(const struct dls_circuit*, int);
+const char* dlsNetName(const struct dls_circuit*, int);
+int dlsFindNet(const struct dls_circuit*, const char*);
+
+struct dls_state* dlsStateNew(const struct dls_circuit*);
+void dlsStateFree(struct dls_state*);
+void dlsSetInput(struct dls_state*, int, uint64_t);
+void dlsSetGrayInputs(struct dls_state*, uint64_t);
+uint64_t dlsGetInput(const struct dls_state*, int);
+uint64_t dlsGetOutput(const struct dls_state*, int);
+uint64_t dlsGetNet(const struct dls_state*, int);
+void dlsEvalWords(const struct dls_circuit*, struct dls_state*);
+int dlsEval(const struct dls_circuit*, const unsigned char*, unsigned char*, size_t);
+
+int dlsNumRegisters(const struct dls_circuit*);
+void dlsResetRegisters(struct dls_state*);
+void dlsClock(const struct dls_circuit*, struct dls_state*);
+void dlsRunCycles(const struct dls_circuit*, struct dls_state*, long, const uint64_t*, uint64_t*);
+
+int dlsNumFaults(const struct dls_circuit*);
+int dlsFaultSim(const struct dls_circuit*, const unsigned char*, uint64_t, int, unsigned char*);
+
+int dlsActivity(const struct dls_circuit*, const unsigned char*, uint64_t, uint64_t*, uint64_t*);
+
+void dlsSetRandomInputs(struct dls_state*, uint64_t, uint64_t);
+int dlsMonteCarlo(const struct dls_circuit*, uint64_t, uint64_t, int, uint64_t*);
+
+struct dls_pool* dlsPoolNew(const struct dls_circuit*, int);
+void dlsPoolFree(struct dls_pool*);
+int dlsPoolNumStages(const struct dls_pool*);
+void dlsPoolEval(struct dls_pool*, struct dls_state*);
+
+struct dls_tiling* dlsTilingNew(const struct dls_circuit*, long);
+void dlsTilingFree(struct dls_tiling*);
+int dlsTilingNumTiles(const struct dls_tiling*);
+int dlsTilingTileGates(const struct dls_tiling*);
+int dlsTilingBlockWords(const struct dls_tiling*);
+int dlsTilingNumSpilled(const struct dls_tiling*);
+void dlsTilingEval(struct dls_tiling*, long, const uint64_t*, uint64_t*);
+
+struct dls_program* dlsProgramNew(const struct dls_circuit*);
+void dlsProgramFree(struct dls_program*);
+int dlsProgramNumInsns(const struct dls_program*);
+int dlsProgramNumFused(const struct dls_program*);
+void dlsProgramEval(const struct dls_program*, struct dls_state*);
+
+struct dls_xstate* dlsXStateNew(const struct dls_circuit*);
+void dlsXStateFree(struct dls_xstate*);
+void dlsXSetInput(struct dls_xstate*, int, uint64_t, uint64_t);
+void dlsXGetOutput(const struct dls_xstate*, int, uint64_t*, uint64_t*);
+void dlsXGetNet(const struct dls_xstate*, int, uint64_t*, uint64_t*);
+void dlsXResetRegisters(struct dls_xstate*);
+void dlsXClock(const struct dls_circuit*, struct dls_xstate*);
+void dlsXEvalWords(const struct dls_circuit*, struct dls_xstate*);
+int dlsXEval(const struct dls_circuit*, const unsigned char*, unsigned char*, size_t);
+
+struct dls_timing* dlsTimingNew(const struct dls_circuit*);
+void dlsTimingFree(struct dls_timing*);
+int dlsTimingSetTypeDelay(struct dls_timing*, const char*, int);
+int dlsTimingSetDelay(struct dls_timing*, int, int);
+int dlsTimingSweep(struct dls_timing*, struct dls_timing_stats*);
+uint64_t dlsTimingNumEvents(const struct dls_timing*);
+
+int dlsAnalyze(const struct dls_circuit*, struct dls_analysis*);
+void dlsAnalysisFree(struct dls_analysis*);
+int dlsFanoutOrder(const struct dls_circuit*, int*);
+
+struct dls_support* dlsSupportNew(const struct dls_circuit*, int*);
+void dlsSupportFree(struct dls_support*);
+int dlsSupportNumGroups(const struct dls_support*);
+int dlsSupportGroupInputs(const struct dls_support*, int, const int**);
+int dlsSupportGroupOutputs(const struct dls_support*, int, const int**);
+uint64_t dlsSupportSwept(const struct dls_support*);
+int dlsSupportLookup(const struct dls_support*, int, uint64_t);
+void dlsSupportEval(const struct dls_support*, struct dls_state*);
+
+int dlsCofactorRun(const struct dls_circuit*, int, uint64_t, uint64_t, int,
+		void (*)(void*, uint64_t, uint64_t, const uint64_t*), void*, struct dls_cofactor_stats*);
+
+int dlsSchedThreads(int);
+int dlsSchedRun(const struct dls_circuit*, const unsigned char*, uint64_t, uint64_t, int,
+		void (*)(void*, uint64_t, uint64_t, const uint64_t*), void*, struct dls_sched_stats*);
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef DLS_INTERNAL_H
+#define DLS_INTERNAL_H
+
+#include<stdbool.h>
+#include "dls.h"
+
+/*
+ * Gate types, same numbering as struct line in first and second
+ */
+#define OP_NOT 0
+#define OP_AND 1
+#define OP_OR 2
+#define OP_NAND 3
+#define OP_NOR 4
+#define OP_XOR 5
+#define OP_XNOR 6
+#define OP_DECODER 7
+#define OP_MULTIPLEXER 8
+#define OP_INSTANCE 9
+#define OP_DEAD 10 //Instance removed by flattening, dropped before compiling
+
+/*Decoders with more selects than this only touch the outputs that change*/
+#define SPARSE_SELECTS 20
+
+/*Net ids of the constants "0" and "1"*/
+#define NET_ZERO 0
+#define NET_ONE 1
+
+/*
+ * Structure: gate
+ *
+ * One component of the circuit, referencing its nets by id
+ *
+ * oper: The type of logic gate, one of the OP_ values
+ *
+ * num_inputs: Number of input nets, any number from 2 up for AND to XNOR
+ *	For decoders and multiplexers: the number of selects
+ *
+ * num_outputs: Number of output nets
+ *
+ * pin: Offset of the first net id of the gate in the circuit's pins array
+ *	The inputs come first, then the multiplexer encodings, then the outputs
+ *
+ * inputs: Net ids of the inputs (selects for multiplexers), points into pins
+ *
+ * outputs: Net ids of the outputs, points into pins
+ *
+ * multi: Only used for multiplexers, net ids of the 2^num_inputs encoding inputs
+ *
+ * level: Logic level assigned by dlsCompile, 1 for gates fed only by primary inputs
+ *
+ * sub: Only used for instances, the compiled module template
+ *	The inputs and outputs are the nets bound to the module's INPUTVAR and OUTPUTVAR
+ *
+ * inst: Only used for instances, index of the instance name in inst_names
+ *
+ * hot: Only used for decoders wider than SPARSE_SELECTS, slot of the first of 64 words
+ *	past the nets of a state, word k holding the output lane k set last; -1 otherwise
+ *
+ */
+struct gate {
+	int oper;
+	int num_inputs;
+	int num_outputs;
+	int pin;
+	int* inputs;
+	int* outputs;
+	int* multi;
+	int level;
+	struct dls_circuit* sub;
+	int inst;
+	int hot;
+};
+
+/*
+ * Structure: reg
+ *
+ * A D flip-flop, latched by dlsClock
+ *
+ * d: Net id of the data input
+ *
+ * q: Net id of the output, a source for the combinational logic
+ *
+ * rst: Net id of the synchronous reset, -1 if the flip-flop has none
+ *	When the reset is 1 at the clock, q becomes 0
+ *
+ */
+struct reg {
+	int d;
+	int q;
+	int rst;
+};
+
+/*
+ * Structure: dls_circuit
+ *
+ * A loaded circuit
+ *
+ * name_pool: Every net name once, each followed by a NUL
+ *
+ * name_start: Offset of each net's name in name_pool, num_nets+1 entries so that
+ *	name_start[num_nets] is the used length of the pool; ids 0 and 1 are the constants
+ *	Net ids follow the file; once compiled, gates, pins, inputs, outputs and
+ *	flip-flops hold slots, the position of the net's word in a state
+ *
+ * buckets, chain: Hash table from name to net id, chained through chain[id]
+ *
+ * gates: The gates in file order
+ *
+ * pins: Net ids of the inputs and outputs of all gates, shared so that a gate's
+ *	fanin is one contiguous run instead of its own allocation
+ *
+ * inputs, outputs: Net ids of the INPUTVAR and OUTPUTVAR lists
+ *
+ * regs: The flip-flops in file order
+ *
+ * order: Gate indices sorted by level, filled in by dlsCompile
+ *
+ * level_start: order[level_start[l-1]] to order[level_start[l]-1] are the gates of level l
+ *
+ * net_slot, slot_net: Net id to slot and back, filled in by dlsCompile
+ *
+ * scratch_words: Words of scratch needed by the widest decoder or multiplexer
+ *
+ * num_words: Words of a state, the nets and then the hot words of the wide decoders
+ *
+ * modules: Templates defined with MODULE, only in the top level circuit
+ *
+ * inst_names: Names of the instances of this circuit
+ *
+ * name, module_index: For a template, its name and position in the top level modules
+ *
+ * has_regs: True if the circuit or any module it instantiates holds flip-flops
+ *
+ * sweep_bit, bit_input: Gray code bit driving each input and input driven by each
+ *	bit, set by dlsSetSweepOrder; NULL when input j takes bit num_inputs-1-j
+ *
+ */
+struct dls_circuit {
+	char* name_pool;
+	size_t pool_cap;
+	size_t* name_start;
+	int num_nets;
+	int cap_nets;
+	int* buckets;
+	int num_buckets;
+	int* chain;
+	struct gate* gates;
+	int num_gates;
+	int cap_gates;
+	int* pins;
+	int num_pins;
+	int cap_pins;
+	int* inputs;
+	int num_inputs;
+	int* outputs;
+	int num_outputs;
+	struct reg* regs;
+	int num_regs;
+	int cap_regs;
+	int* order;
+	int* level_start;
+	int num_levels;
+	int scratch_words;
+	int num_words;
+	int* net_slot;
+	int* slot_net;
+	struct dls_circuit** modules;
+	int num_modules;
+	int cap_modules;
+	char** inst_names;
+	int num_insts;
+	int cap_insts;
+	char* name;
+	int module_index;
+	bool has_regs;
+	bool compiled;
+	int* sweep_bit;
+	int* bit_input;
+};
+
+/*
+ * Structure: dls_state
+ *
+ * Per-thread evaluation state, one 64 bit word per net
+ * Bit k of every word belongs to the k-th of the 64 vectors evaluated together
+ *
+ * latch: One word per flip-flop, the next state while the registers are clocked
+ *
+ * subs: One state per module template, shared by all instances of that module
+ *	since an instance is evaluated completely before the next one starts
+ *
+ */
+struct dls_state {
+	const struct dls_circuit* circuit;
+	uint64_t* nets;
+	uint64_t* scratch;
+	uint64_t* latch;
+	struct dls_state** subs;
+	int num_subs;
+};
+
+/*
+ * Function: netName
+ *
+ * returns: The name of a net id
+ */
+static inline const char* netName(const struct dls_circuit* c, int id) {
+	return c->name_pool + c->name_start[id];
+}
+
+/*
+ * Function: slotNet
+ *
+ * returns: The net id of a slot, the slot itself before the circuit is compiled
+ */
+static inline int slotNet(const struct dls_circuit* c, int slot) {
+	return (c->slot_net != NULL) ? c->slot_net[slot] : slot;
+}
+
+/*
+ * Function: sweepBit
+ *
+ * returns: The bit of the sweep's gray code applied to an input
+ */
+static inline int sweepBit(const struct dls_circuit* c, int input) {
+	return (c->sweep_bit != NULL) ? c->sweep_bit[input] : c->num_inputs - 1 - input;
+}
+
+/*
+ * Function: sweepInput
+ *
+ * returns: The input a bit of the sweep's gray code is applied to
+ */
+static inline int sweepInput(const struct dls_circuit* c, int bit) {
+	return (c->bit_input != NULL) ? c->bit_input[bit] : c->num_inputs - 1 - bit;
+}
+
+uint64_t grayToBinary64(uint64_t);
+void evalGate(const struct gate*, uint64_t*, uint64_t*);
+void evalNets(const struct dls_circuit*, uint64_t*, uint64_t*, struct dls_state**);
+struct dls_circuit* newCircuit(void);
+bool tokenIs(const char*, size_t, const char*);
+int intern(struct dls_circuit*, const char*, size_t);
+struct gate* newGate(struct dls_circuit*, int, int, int);
+struct reg* newReg(struct dls_circuit*);
+int newInstName(struct dls_circuit*, const char*, size_t);
+int flattenInstances(struct dls_circuit*, bool);
+void evalInstance(const struct gate*, uint64_t*, struct dls_state**);
+void linkPins(struct dls_circuit*, struct gate*);
+int layoutCircuit(struct dls_circuit*);
+int gateNumFanin(const struct gate*);
+int gateFanin(const struct gate*, int);
+uint64_t* collectSupports(const struct dls_circuit*, int);
+
+#endif
@@ -0,0 +1,229 @@
+#define _POSIX_C_SOURCE 200809L
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include<stdatomic.h>
+#include<unistd.h>
+#include "dls_internal.h"
+
+/*
+ * Parallel stuck-at fault simulation
+ *
+ * Every net except the constants carries a stuck-at-0 and a stuck-at-1 fault.
+ * Fault f is net f/2+2 stuck at f%2. Faults are simulated in groups of 63:
+ * bit 0 of every word is the good machine and bit k the machine with the
+ * (k-1)-th fault of the group. A fault is injected by masking its bit on the net
+ * right after the net is computed, and is detected when any output bit of its
+ * machine differs from the good machine. Detected faults are dropped, and a
+ * group stops as soon as all of its faults are detected. Groups are handed out
+ * to threads one at a time.
+ */
+
+/*Faulty machines per word, bit 0 is the good machine*/
+#define FAULTS_PER_GROUP 63
+
+/*
+ * Structure: faultjob
+ *
+ * Work shared by the fault simulation threads
+ *
+ * vectors: count rows of num_inputs bytes, NULL for the exhaustive gray code sweep
+ *
+ * next_group: Next group of faults to hand out
+ *
+ */
+struct faultjob {
+	const struct dls_circuit* circuit;
+	const unsigned char* vectors;
+	uint64_t count;
+	unsigned char* detected;
+	int num_faults;
+	int num_groups;
+	atomic_int next_group;
+	atomic_int rc;
+};
+
+int dlsNumFaults(const struct dls_circuit* c) {
+	return 2*(c->num_nets - 2);
+}
+
+/*
+ * Function: setVector
+ *
+ * Broadcasts one input vector to all 64 machines
+ *
+ */
+static void setVector(const struct faultjob* job, uint64_t* v, uint64_t index) {
+	const struct dls_circuit* c = job->circuit;
+	int n = c->num_inputs;
+	if(job->vectors != NULL) {
+		const unsigned char* row = job->vectors + index*n;
+		for(int j = 0; j < n; j++) {
+			v[c->inputs[j]] = (row[j] & 1) ? ~(uint64_t)0 : 0;
+		}
+		return;
+	}
+	uint64_t gray = index ^ (index >> 1);
+	for(int j = 0; j < n; j++) {
+		v[c->inputs[j]] = ((gray >> sweepBit(c, j)) & 1) ? ~(uint64_t)0 : 0;
+	}
+}
+
+/*
+ * Function: faultWorker
+ *
+ * Thread body, simulates groups of faults until none are left
+ *
+ */
+static void* faultWorker(void* arg) {
+	struct faultjob* job = arg;
+	const struct dls_circuit* c = job->circuit;
+	struct dls_state* s = dlsStateNew(c);
+	uint64_t* inj_and = malloc(c->num_nets*sizeof(uint64_t));
+	uint64_t* inj_or = malloc(c->num_nets*sizeof(uint64_t));
+	if(s == NULL || inj_and == NULL || inj_or == NULL) {
+		atomic_store(&job->rc, DLS_ERR_NOMEM);
+		dlsStateFree(s);
+		free(inj_and);
+		free(inj_or);
+		return NULL;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		inj_and[i] = ~(uint64_t)0;
+		inj_or[i] = 0;
+	}
+	uint64_t* v = s->nets;
+	int group;
+	while((group = atomic_fetch_add(&job->next_group, 1)) < job->num_groups) {
+		int first = group*FAULTS_PER_GROUP;
+		int last = first + FAULTS_PER_GROUP;
+		if(last > job->num_faults) {
+			last = job->num_faults;
+		}
+		memset(v, 0, c->num_words*sizeof(uint64_t)); //Wide decoders only clear the outputs they set, not stuck-at-1 bits of the last group
+		v[NET_ONE] = ~(uint64_t)0;
+		uint64_t pending = 0;
+		for(int f = first; f < last; f++) {
+			uint64_t bit = (uint64_t)1 << (f - first + 1);
+			int slot = c->net_slot[f/2 + 2];
+			if(f % 2 == 0) {
+				inj_and[slot] &= ~bit;
+			}
+			else {
+				inj_or[slot] |= bit;
+			}
+			pending |= bit;
+		}
+		for(uint64_t i = 0; i < job->count && pending != 0; i++) {
+			setVector(job, v, i);
+			for(int j = 0; j < c->num_inputs; j++) {
+				int net = c->inputs[j];
+				v[net] = (v[net] & inj_and[net]) | inj_or[net];
+			}
+			for(int r = 0; r < c->num_regs; r++) { //Flip-flops are held at 0
+				int net = c->regs[r].q;
+				v[net] = inj_or[net];
+			}
+			for(int k = 0; k < c->num_gates; k++) {
+				const struct gate* g = &c->gates[c->order[k]];
+				evalGate(g, v, s->scratch);
+				for(int o = 0; o < g->num_outputs; o++) {
+					int net = g->outputs[o];
+					v[net] = (v[net] & inj_and[net]) | inj_or[net];
+				}
+			}
+			uint64_t diff = 0;
+			for(int o = 0; o < c->num_outputs; o++) {
+				uint64_t w = v[c->outputs[o]];
+				diff |= w ^ -(w & 1); //Compare every machine with the good one
+			}
+			uint64_t found = diff & pending;
+			pending &= ~found;
+			while(found != 0) {
+				int lane = __builtin_ctzll(found);
+				job->detected[first + lane - 1] = 1;
+				found &= found - 1;
+			}
+		}
+		for(int f = first; f < last; f++) {
+			inj_and[c->net_slot[f/2 + 2]] = ~(uint64_t)0;
+			inj_or[c->net_slot[f/2 + 2]] = 0;
+		}
+	}
+	free(inj_and);
+	free(inj_or);
+	dlsStateFree(s);
+	return NULL;
+}
+
+/*
+ * Function: dlsFaultSim
+ *
+ * Grades a vector set against every single stuck-at fault
+ * Instances must have been flattened with dlsFlatten before compiling
+ *
+ * c: The compiled circuit
+ *
+ * vectors: count rows of dlsNumInputs bytes, 0 or 1
+ *	NULL to apply all 2^n input combinations in gray code order
+ *
+ * count: Number of vectors, ignored for the full sweep
+ *
+ * threads: Number of threads, 0 for one per online processor
+ *
+ * detected: dlsNumFaults bytes, set to 1 for detected faults and 0 otherwise
+ *
+ * returns: DLS_OK, DLS_ERR_STATE, DLS_ERR_ARG if the sweep is too wide, or DLS_ERR_NOMEM
+ */
+int dlsFaultSim(const struct dls_circuit* c, const unsigned char* vectors, uint64_t count, int threads, unsigned char* detected) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		if(c->gates[g].oper == OP_INSTANCE) {
+			return DLS_ERR_STATE;
+		}
+	}
+	if(vectors == NULL) {
+		if(c->num_inputs > 63) {
+			return DLS_ERR_ARG;
+		}
+		count = (uint64_t)1 << c->num_inputs;
+	}
+	struct faultjob job;
+	job.circuit = c;
+	job.vectors = vectors;
+	job.count = count;
+	job.detected = detected;
+	job.num_faults = dlsNumFaults(c);
+	job.num_groups = (job.num_faults + FAULTS_PER_GROUP - 1)/FAULTS_PER_GROUP;
+	atomic_init(&job.next_group, 0);
+	atomic_init(&job.rc, DLS_OK);
+	memset(detected, 0, job.num_faults);
+	if(threads <= 0) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(threads > job.num_groups) {
+		threads = job.num_groups;
+	}
+	if(threads < 1) {
+		threads = 1;
+	}
+	pthread_t* tids = malloc(threads*sizeof(pthread_t));
+	if(tids == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	int started = 0;
+	for(int t = 1; t < threads; t++) {
+		if(pthread_create(&tids[t], NULL, faultWorker, &job) != 0) {
+			break;
+		}
+		started++;
+	}
+	faultWorker(&job); //The calling thread works too
+	for(int t = 1; t <= started; t++) {
+		pthread_join(tids[t], NULL);
+	}
+	free(tids);
+	return atomic_load(&job.rc);
+}
@@ -0,0 +1,1183 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * BLIF and structural Verilog front ends
+ *
+ * Both read the netlist in a single pass with a scanner that hands out tokens as
+ * pointers into the buffer, intern the names directly and append the same gates
+ * and flip-flops as the native format, so the result goes through dlsCompile like
+ * any other circuit. Nets the importers add themselves are named $1, $2, ...
+ */
+
+/*Covers with at most this many inputs are matched against the fixed gates by truth table*/
+#define TABLE_INPUTS 6
+
+/*Covers with at most this many inputs that no single gate matches become multiplexer lookup tables*/
+#define LUT_INPUTS 4
+
+/*
+ * Structure: scanner
+ *
+ * Cursor over a netlist held in memory
+ *
+ */
+struct scanner {
+	const char* p;
+	const char* end;
+};
+
+/*
+ * Structure: importer
+ *
+ * Circuit under construction and the growable lists the importers share
+ *
+ * inverted: Net id to the id of its inverted copy, -1 if there is none yet
+ *
+ * temps: Number of nets added by the importer, used to name the next one
+ *
+ * ids: Net ids of the statement being read
+ *
+ * cubes: Input parts of the cover of the .names being read, k characters each
+ *
+ */
+struct importer {
+	struct dls_circuit* c;
+	int cap_inputs;
+	int cap_outputs;
+	int* inverted;
+	int cap_inverted;
+	int temps;
+	int* ids;
+	int num_ids;
+	int cap_ids;
+	char* cubes;
+	size_t cap_cubes;
+};
+
+/*
+ * Function: appendNet
+ *
+ * Appends a net id to a growable list
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int appendNet(int** list, int* count, int* cap, int id) {
+	if(*count == *cap) {
+		int grown_cap = *cap ? *cap*2 : 16;
+		int* grown = realloc(*list, grown_cap*sizeof(int));
+		if(grown == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		*list = grown;
+		*cap = grown_cap;
+	}
+	(*list)[(*count)++] = id;
+	return DLS_OK;
+}
+
+/*
+ * Function: tempNet
+ *
+ * Creates a net for an intermediate value
+ *
+ * returns: The net id, or DLS_ERR_NOMEM
+ */
+static int tempNet(struct importer* im) {
+	char name[16];
+	int len = 0;
+	unsigned n = ++im->temps;
+	char digits[12];
+	int d = 0;
+	do {
+		digits[d++] = '0' + n % 10;
+		n /= 10;
+	} while(n != 0);
+	name[len++] = '$';
+	while(d > 0) {
+		name[len++] = digits[--d];
+	}
+	return intern(im->c, name, len);
+}
+
+/*
+ * Function: addGate
+ *
+ * Appends a single output gate
+ *
+ * in: Net ids of the inputs
+ *
+ * n: Number of inputs, 1 for NOT and at least 2 for the others
+ *
+ * out: Net id of the output
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int addGate(struct importer* im, int oper, const int* in, int n, int out) {
+	struct gate* g = newGate(im->c, oper, n, 1);
+	if(g == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	memcpy(g->inputs, in, n*sizeof(int));
+	g->outputs[0] = out;
+	return DLS_OK;
+}
+
+/*
+ * Function: addBuffer
+ *
+ * Copies one net to another with a two input AND of the net with itself
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int addBuffer(struct importer* im, int in, int out) {
+	int pair[2] = {in, in};
+	return addGate(im, OP_AND, pair, 2, out);
+}
+
+/*
+ * Function: invertNet
+ *
+ * Returns the inverse of a net, adding one NOT gate per net at most
+ *
+ * returns: The net id of the inverse, or DLS_ERR_NOMEM
+ */
+static int invertNet(struct importer* im, int net) {
+	if(net == NET_ZERO || net == NET_ONE) {
+		return NET_ONE - net;
+	}
+	if(net >= im->cap_inverted) {
+		int cap = im->cap_inverted ? im->cap_inverted : 64;
+		while(cap <= net) {
+			cap *= 2;
+		}
+		int* grown = realloc(im->inverted, cap*sizeof(int));
+		if(grown == NULL) {
+			return DLS_ERR_NOMEM;
+		}
+		for(int i = im->cap_inverted; i < cap; i++) {
+			grown[i] = -1;
+		}
+		im->inverted = grown;
+		im->cap_inverted = cap;
+	}
+	if(im->inverted[net] == -1) {
+		int inv = tempNet(im);
+		if(inv < 0) {
+			return inv;
+		}
+		int rc = addGate(im, OP_NOT, &net, 1, inv);
+		if(rc != DLS_OK) {
+			return rc;
+		}
+		im->inverted[net] = inv;
+	}
+	return im->inverted[net];
+}
+
+/*
+ * Function: matchGate
+ *
+ * Finds the gate over all k inputs whose truth table is t
+ * Bit b of t is the output when input i holds bit k-1-i of b
+ *
+ * returns: The OP_ value, or -1 if no gate matches
+ */
+static int matchGate(uint64_t t, int k) {
+	uint64_t rows = (uint64_t)1 << k;
+	uint64_t mask = (k == 6) ? ~(uint64_t)0 : (((uint64_t)1 << rows) - 1);
+	uint64_t parity = 0;
+	for(uint64_t b = 0; b < rows; b++) {
+		parity |= (uint64_t)(__builtin_popcountll(b) & 1) << b;
+	}
+	if(t == (uint64_t)1 << (rows - 1)) {
+		return OP_AND;
+	}
+	if(t == (mask & ~((uint64_t)1 << (rows - 1)))) {
+		return OP_NAND;
+	}
+	if(t == (mask & ~(uint64_t)1)) {
+		return OP_OR;
+	}
+	if(t == 1) {
+		return OP_NOR;
+	}
+	if(t == parity) {
+		return OP_XOR;
+	}
+	if(t == (mask & ~parity)) {
+		return OP_XNOR;
+	}
+	return -1;
+}
+
+/*
+ * Function: buildCover
+ *
+ * Turns the single output cover of a .names into gates driving out
+ * A cover that a single gate computes becomes that gate, a small one a multiplexer
+ * with constant encodings, and any other one a sum of products
+ *
+ * in: Net ids of the k inputs
+ *
+ * cubes: num_cubes rows of k characters, 0, 1 or -
+ *
+ * onset: True if the rows list where the output is 1, false where it is 0
+ *
+ * returns: DLS_OK or an error code
+ */
+static int buildCover(struct importer* im, const int* in, int k, int out, const char* cubes, int num_cubes, bool onset) {
+	if(k <= TABLE_INPUTS) {
+		uint64_t rows = (uint64_t)1 << k;
+		uint64_t t = 0;
+		for(int q = 0; q < num_cubes; q++) {
+			const char* cube = cubes + (size_t)q*k;
+			for(uint64_t b = 0; b < rows; b++) {
+				bool hit = true;
+				for(int i = 0; i < k && hit; i++) {
+					int bit = (b >> (k - 1 - i)) & 1;
+					hit = (cube[i] == '-' || cube[i] - '0' == bit);
+				}
+				if(hit) {
+					t |= (uint64_t)1 << b;
+				}
+			}
+		}
+		uint64_t mask = (k == 6) ? ~(uint64_t)0 : (((uint64_t)1 << rows) - 1);
+		if(!onset) {
+			t = ~t & mask;
+		}
+		if(t == 0 || t == mask) {
+			return addBuffer(im, (t == 0) ? NET_ZERO : NET_ONE, out);
+		}
+		if(k == 1) {
+			return (t == 2) ? addBuffer(im, in[0], out) : addGate(im, OP_NOT, in, 1, out);
+		}
+		int op = matchGate(t, k);
+		if(op >= 0) {
+			return addGate(im, op, in, k, out);
+		}
+		if(k <= LUT_INPUTS) {
+			struct gate* g = newGate(im->c, OP_MULTIPLEXER, k, 1);
+			if(g == NULL) {
+				return DLS_ERR_NOMEM;
+			}
+			memcpy(g->inputs, in, k*sizeof(int));
+			for(uint64_t j = 0; j < rows; j++) { //Selects s pick encoding grayToBinary(s)
+				g->multi[j] = ((t >> (j ^ (j >> 1))) & 1) ? NET_ONE : NET_ZERO;
+			}
+			g->outputs[0] = out;
+			return DLS_OK;
+		}
+	}
+	/*Sum of products, one AND per cube, then OR (NOR for an off-set cover)*/
+	int* terms = malloc((num_cubes + 1)*sizeof(int));
+	int* lits = malloc((k + 1)*sizeof(int));
+	int rc = (terms == NULL || lits == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+	int num_terms = 0;
+	bool tautology = false;
+	for(int q = 0; q < num_cubes && rc == DLS_OK && !tautology; q++) {
+		const char* cube = cubes + (size_t)q*k;
+		int num_lits = 0;
+		for(int i = 0; i < k && rc == DLS_OK; i++) {
+			if(cube[i] == '1') {
+				lits[num_lits++] = in[i];
+			}
+			else if(cube[i] == '0') {
+				int inv = invertNet(im, in[i]);
+				if(inv < 0) {
+					rc = inv;
+				}
+				lits[num_lits++] = inv;
+			}
+		}
+		if(rc != DLS_OK) {
+			break;
+		}
+		if(num_lits == 0) {
+			tautology = true;
+		}
+		else if(num_lits == 1) {
+			terms[num_terms++] = lits[0];
+		}
+		else if(num_cubes == 1 && onset) {
+			rc = addGate(im, OP_AND, lits, num_lits, out);
+			num_terms = -1; //Done
+		}
+		else {
+			int term = tempNet(im);
+			rc = (term < 0) ? term : addGate(im, OP_AND, lits, num_lits, term);
+			terms[num_terms++] = term;
+		}
+	}
+	if(rc == DLS_OK && tautology) {
+		rc = addBuffer(im, onset ? NET_ONE : NET_ZERO, out);
+	}
+	else if(rc == DLS_OK && num_terms == 0) {
+		rc = addBuffer(im, onset ? NET_ZERO : NET_ONE, out);
+	}
+	else if(rc == DLS_OK && num_terms == 1) {
+		rc = onset ? addBuffer(im, terms[0], out) : addGate(im, OP_NOT, terms, 1, out);
+	}
+	else if(rc == DLS_OK && num_terms > 1) {
+		rc = addGate(im, onset ? OP_OR : OP_NOR, terms, num_terms, out);
+	}
+	free(terms);
+	free(lits);
+	return rc;
+}
+
+/*
+ * Function: lineToken
+ *
+ * Next token on the current line of a BLIF file
+ * A backslash at the end of a line continues it, # starts a comment
+ *
+ * returns: true if a token was found, false at the end of the line, which is consumed
+ */
+static bool lineToken(struct scanner* sc, const char** tok, size_t* len) {
+	for(;;) {
+		while(sc->p < sc->end && (*sc->p == ' ' || *sc->p == '\t' || *sc->p == '\r')) {
+			sc->p++;
+		}
+		if(sc->p < sc->end && *sc->p == '\\' && sc->p + 1 < sc->end && (sc->p[1] == '\n' || sc->p[1] == '\r')) {
+			sc->p++;
+			while(sc->p < sc->end && *sc->p != '\n') {
+				sc->p++;
+			}
+			sc->p++;
+			continue;
+		}
+		if(sc->p < sc->end && *sc->p == '#') {
+			while(sc->p < sc->end && *sc->p != '\n') {
+				sc->p++;
+			}
+		}
+		break;
+	}
+	if(sc->p >= sc->end) {
+		sc->p = sc->end;
+		return false;
+	}
+	if(*sc->p == '\n') {
+		sc->p++;
+		return false;
+	}
+	*tok = sc->p;
+	while(sc->p < sc->end && *sc->p != ' ' && *sc->p != '\t' && *sc->p != '\r' && *sc->p != '\n') {
+		sc->p++;
+	}
+	*len = sc->p - *tok;
+	return true;
+}
+
+/*
+ * Function: skipLine
+ *
+ * Consumes the rest of the current BLIF line
+ *
+ */
+static void skipLine(struct scanner* sc) {
+	const char* tok;
+	size_t len;
+	while(lineToken(sc, &tok, &len)) {
+	}
+}
+
+/*
+ * Function: readLineNets
+ *
+ * Interns every name on the rest of the line into the importer's ids
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int readLineNets(struct importer* im, struct scanner* sc) {
+	const char* tok;
+	size_t len;
+	im->num_ids = 0;
+	while(lineToken(sc, &tok, &len)) {
+		int id = intern(im->c, tok, len);
+		if(id < 0 || appendNet(&im->ids, &im->num_ids, &im->cap_ids, id) != DLS_OK) {
+			return DLS_ERR_NOMEM;
+		}
+	}
+	return DLS_OK;
+}
+
+/*
+ * Function: parseNames
+ *
+ * Reads the cover lines following a .names whose nets are in the importer's ids
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseNames(struct importer* im, struct scanner* sc) {
+	if(im->num_ids == 0) {
+		return DLS_ERR_SYNTAX;
+	}
+	int k = im->num_ids - 1;
+	int num_cubes = 0;
+	int value = -1;
+	for(;;) {
+		struct scanner peek = *sc;
+		const char* tok;
+		size_t len;
+		if(!lineToken(&peek, &tok, &len)) {
+			if(peek.p >= peek.end) {
+				break;
+			}
+			*sc = peek; //Blank line
+			continue;
+		}
+		if(*tok == '.') {
+			break;
+		}
+		*sc = peek;
+		const char* cube = tok;
+		if(k > 0) {
+			if((int)len != k || !lineToken(sc, &tok, &len)) {
+				return DLS_ERR_SYNTAX;
+			}
+		}
+		if(len != 1 || (*tok != '0' && *tok != '1') || (value != -1 && *tok - '0' != value)) {
+			return DLS_ERR_SYNTAX; //Mixed on-set and off-set rows
+		}
+		value = *tok - '0';
+		skipLine(sc);
+		if((size_t)(num_cubes + 1)*k > im->cap_cubes) {
+			size_t cap = im->cap_cubes ? im->cap_cubes*2 : 256;
+			while(cap < (size_t)(num_cubes + 1)*k) {
+				cap *= 2;
+			}
+			char* grown = realloc(im->cubes, cap);
+			if(grown == NULL) {
+				return DLS_ERR_NOMEM;
+			}
+			im->cubes = grown;
+			im->cap_cubes = cap;
+		}
+		for(int i = 0; i < k; i++) {
+			if(cube[i] != '0' && cube[i] != '1' && cube[i] != '-') {
+				return DLS_ERR_SYNTAX;
+			}
+		}
+		memcpy(im->cubes + (size_t)num_cubes*k, cube, k);
+		num_cubes++;
+	}
+	return buildCover(im, im->ids, k, im->ids[k], im->cubes, num_cubes, value != 0);
+}
+
+/*
+ * Function: parseLatch
+ *
+ * Reads ".latch input output [type control] [init]" into a flip-flop
+ * An initial value of 1 is kept by storing the inverse of the latch
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseLatch(struct importer* im, struct scanner* sc) {
+	const char* tok[5];
+	size_t len[5];
+	int n = 0;
+	const char* t;
+	size_t l;
+	while(lineToken(sc, &t, &l)) {
+		if(n == 5) {
+			return DLS_ERR_SYNTAX;
+		}
+		tok[n] = t;
+		len[n++] = l;
+	}
+	if(n < 2) {
+		return DLS_ERR_SYNTAX;
+	}
+	bool init_one = (n == 3 || n == 5) && len[n - 1] == 1 && *tok[n - 1] == '1';
+	int d = intern(im->c, tok[0], len[0]);
+	int q = intern(im->c, tok[1], len[1]);
+	if(d < 0 || q < 0) {
+		return DLS_ERR_NOMEM;
+	}
+	struct reg* r = newReg(im->c);
+	if(r == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	r->rst = -1;
+	if(!init_one) {
+		r->d = d;
+		r->q = q;
+		return DLS_OK;
+	}
+	int nd = invertNet(im, d);
+	int nq = tempNet(im);
+	if(nd < 0 || nq < 0) {
+		return DLS_ERR_NOMEM;
+	}
+	r->d = nd;
+	r->q = nq;
+	return addGate(im, OP_NOT, &nq, 1, q);
+}
+
+/*
+ * Function: newImporter
+ *
+ * Starts an empty circuit with room for its inputs and outputs
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int newImporter(struct importer* im) {
+	memset(im, 0, sizeof(struct importer));
+	im->c = newCircuit();
+	if(im->c == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	im->cap_inputs = 16;
+	im->cap_outputs = 16;
+	im->c->inputs = malloc(im->cap_inputs*sizeof(int));
+	im->c->outputs = malloc(im->cap_outputs*sizeof(int));
+	return (im->c->inputs == NULL || im->c->outputs == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+}
+
+/*
+ * Function: finishImport
+ *
+ * Hands over the circuit on success and releases the importer
+ *
+ * returns: rc
+ */
+static int finishImport(struct importer* im, int rc, struct dls_circuit** out) {
+	free(im->inverted);
+	free(im->ids);
+	free(im->cubes);
+	if(rc != DLS_OK) {
+		dlsFree(im->c);
+		return rc;
+	}
+	*out = im->c;
+	return DLS_OK;
+}
+
+/*
+ * Function: dlsLoadBlif
+ *
+ * Parses the first model of a BLIF netlist
+ * .inputs, .outputs, .names and .latch are read; .latch becomes a DFF, held at 0
+ * like the others unless its initial value is 1. Each .names cover becomes the
+ * single gate it computes if there is one, a multiplexer with constant encodings
+ * for up to LUT_INPUTS inputs, or else an AND per cube feeding an OR.
+ * Hierarchy (.subckt) and library gates (.gate) are not supported.
+ *
+ * out: Set to the loaded circuit on success, NULL otherwise
+ *
+ * buf: The netlist, need not be NUL terminated
+ *
+ * len: Length of buf in bytes
+ *
+ * returns: DLS_OK or an error code
+ */
+int dlsLoadBlif(struct dls_circuit** out, const char* buf, size_t len) {
+	*out = NULL;
+	struct importer im;
+	int rc = newImporter(&im);
+	struct scanner sc = {buf, buf + len};
+	const char* tok;
+	size_t toklen;
+	while(rc == DLS_OK && sc.p < sc.end) {
+		if(!lineToken(&sc, &tok, &toklen)) {
+			continue;
+		}
+		if(tokenIs(tok, toklen, ".inputs") || tokenIs(tok, toklen, ".outputs")) {
+			bool inputs = (toklen == 7);
+			rc = readLineNets(&im, &sc);
+			for(int i = 0; i < im.num_ids && rc == DLS_OK; i++) {
+				rc = inputs ? appendNet(&im.c->inputs, &im.c->num_inputs, &im.cap_inputs, im.ids[i]) :
+						appendNet(&im.c->outputs, &im.c->num_outputs, &im.cap_outputs, im.ids[i]);
+			}
+		}
+		else if(tokenIs(tok, toklen, ".names")) {
+			rc = readLineNets(&im, &sc);
+			if(rc == DLS_OK) {
+				rc = parseNames(&im, &sc);
+			}
+		}
+		else if(tokenIs(tok, toklen, ".latch")) {
+			rc = parseLatch(&im, &sc);
+		}
+		else if(tokenIs(tok, toklen, ".end") || tokenIs(tok, toklen, ".exdc")) {
+			break;
+		}
+		else if(tokenIs(tok, toklen, ".subckt") || tokenIs(tok, toklen, ".gate") || tokenIs(tok, toklen, ".mlatch") || *tok != '.') {
+			rc = DLS_ERR_SYNTAX;
+		}
+		else { //.model, .clock and the timing and area directives
+			skipLine(&sc);
+		}
+	}
+	return finishImport(&im, rc, out);
+}
+
+/*
+ * Function: verilogToken
+ *
+ * Next token of a Verilog file: an identifier, an escaped identifier, a number
+ * with its base and digits, or a single punctuation character
+ * Comments and attributes are skipped
+ *
+ * returns: true if a token was found, false at the end of the buffer
+ */
+static bool verilogToken(struct scanner* sc, const char** tok, size_t* len) {
+	for(;;) {
+		while(sc->p < sc->end && (*sc->p == ' ' || *sc->p == '\t' || *sc->p == '\r' || *sc->p == '\n')) {
+			sc->p++;
+		}
+		if(sc->end - sc->p >= 2 && sc->p[0] == '/' && sc->p[1] == '/') {
+			while(sc->p < sc->end && *sc->p != '\n') {
+				sc->p++;
+			}
+		}
+		else if(sc->end - sc->p >= 2 && ((sc->p[0] == '/' && sc->p[1] == '*') || (sc->p[0] == '(' && sc->p[1] == '*'))) {
+			char close = (sc->p[0] == '/') ? '/' : ')';
+			sc->p += 2;
+			while(sc->end - sc->p >= 2 && !(sc->p[0] == '*' && sc->p[1] == close)) {
+				sc->p++;
+			}
+			sc->p = (sc->end - sc->p >= 2) ? sc->p + 2 : sc->end;
+		}
+		else {
+			break;
+		}
+	}
+	if(sc->p >= sc->end) {
+		return false;
+	}
+	const char* p = sc->p;
+	*tok = p;
+	if(*p == '\\') { //Escaped identifier, up to the next white space
+		while(p < sc->end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+			p++;
+		}
+	}
+	else if((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_' || *p == '$' || *p == '\'') {
+		while(p < sc->end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_' || *p == '$' || *p == '\'')) {
+			p++;
+		}
+	}
+	else {
+		p++;
+	}
+	sc->p = p;
+	*len = p - *tok;
+	return true;
+}
+
+/*
+ * Function: expectToken
+ *
+ * returns: true if the next token is the single character ch, which is consumed
+ */
+static bool expectToken(struct scanner* sc, char ch) {
+	const char* tok;
+	size_t len;
+	return verilogToken(sc, &tok, &len) && len == 1 && *tok == ch;
+}
+
+/*
+ * Function: peekChar
+ *
+ * returns: The first character of the next token without consuming it, or 0 at the end
+ */
+static char peekChar(const struct scanner* sc) {
+	struct scanner peek = *sc;
+	const char* tok;
+	size_t len;
+	return verilogToken(&peek, &tok, &len) ? *tok : 0;
+}
+
+/*
+ * Function: parseInt
+ *
+ * returns: The value of a decimal token, or -1 if it is not one
+ */
+static long parseInt(const char* tok, size_t len) {
+	long ret = 0;
+	for(size_t i = 0; i < len; i++) {
+		if(tok[i] < '0' || tok[i] > '9' || ret > 100000000) {
+			return -1;
+		}
+		ret = ret*10 + (tok[i] - '0');
+	}
+	return (len == 0) ? -1 : ret;
+}
+
+/*
+ * Function: bitName
+ *
+ * Interns the net of one bit of a bus, named "bus[bit]"
+ *
+ * returns: The net id, or DLS_ERR_NOMEM
+ */
+static int bitName(struct dls_circuit* c, const char* tok, size_t len, long bit) {
+	char* name = malloc(len + 24);
+	if(name == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	memcpy(name, tok, len);
+	size_t n = len;
+	name[n++] = '[';
+	char digits[24];
+	int d = 0;
+	do {
+		digits[d++] = '0' + bit % 10;
+		bit /= 10;
+	} while(bit != 0);
+	while(d > 0) {
+		name[n++] = digits[--d];
+	}
+	name[n++] = ']';
+	int id = intern(c, name, n);
+	free(name);
+	return id;
+}
+
+/*
+ * Function: parseNetRef
+ *
+ * Reads a net: an identifier with an optional bit select, or 1'b0 and 1'b1
+ *
+ * returns: The net id, or an error code
+ */
+static int parseNetRef(struct importer* im, struct scanner* sc) {
+	const char* tok;
+	size_t len;
+	if(!verilogToken(sc, &tok, &len)) {
+		return DLS_ERR_SYNTAX;
+	}
+	if(len >= 4 && tok[len - 3] == '\'' && (tok[len - 2] == 'b' || tok[len - 2] == 'B') && (tok[len - 1] == '0' || tok[len - 1] == '1')) {
+		return (tok[len - 1] == '1') ? NET_ONE : NET_ZERO;
+	}
+	if(!((*tok >= 'a' && *tok <= 'z') || (*tok >= 'A' && *tok <= 'Z') || *tok == '_' || *tok == '\\')) {
+		return DLS_ERR_SYNTAX;
+	}
+	if(*tok == '\\') { //The backslash is not part of the name
+		tok++;
+		len--;
+	}
+	if(peekChar(sc) != '[') {
+		return intern(im->c, tok, len);
+	}
+	const char* num;
+	size_t numlen;
+	verilogToken(sc, &num, &numlen);
+	long bit = verilogToken(sc, &num, &numlen) ? parseInt(num, numlen) : -1;
+	if(bit < 0 || !expectToken(sc, ']')) {
+		return DLS_ERR_SYNTAX;
+	}
+	return bitName(im->c, tok, len, bit);
+}
+
+static int parseOr(struct importer*, struct scanner*, int);
+
+/*
+ * Function: parseDeclaration
+ *
+ * Reads the names of an input, output or wire statement up to the semicolon
+ * A range [msb:lsb] declares one net per bit, msb first; a scalar may be followed
+ * by = and an expression to drive it with
+ *
+ * list, count, cap: The list the nets are appended to, NULL for wires
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseDeclaration(struct importer* im, struct scanner* sc, int** list, int* count, int* cap) {
+	long msb = -1;
+	long lsb = -1;
+	const char* tok;
+	size_t len;
+	if(peekChar(sc) == '[') {
+		verilogToken(sc, &tok, &len);
+		msb = verilogToken(sc, &tok, &len) ? parseInt(tok, len) : -1;
+		if(msb < 0 || !expectToken(sc, ':')) {
+			return DLS_ERR_SYNTAX;
+		}
+		lsb = verilogToken(sc, &tok, &len) ? parseInt(tok, len) : -1;
+		if(lsb < 0 || !expectToken(sc, ']')) {
+			return DLS_ERR_SYNTAX;
+		}
+	}
+	for(;;) {
+		if(!verilogToken(sc, &tok, &len)) {
+			return DLS_ERR_SYNTAX;
+		}
+		if(*tok == '\\') {
+			tok++;
+			len--;
+		}
+		long step = (msb >= lsb) ? -1 : 1;
+		int id = DLS_OK;
+		for(long bit = msb; ; bit += step) {
+			id = (msb < 0) ? intern(im->c, tok, len) : bitName(im->c, tok, len, bit);
+			if(id < 0) {
+				return id;
+			}
+			if(list != NULL && appendNet(list, count, cap, id) != DLS_OK) {
+				return DLS_ERR_NOMEM;
+			}
+			if(msb < 0 || bit == lsb) {
+				break;
+			}
+		}
+		if(msb < 0 && peekChar(sc) == '=') { //wire w = expression
+			expectToken(sc, '=');
+			int net = parseOr(im, sc, id);
+			if(net < 0) {
+				return net;
+			}
+		}
+		if(!verilogToken(sc, &tok, &len) || len != 1 || (*tok != ',' && *tok != ';')) {
+			return DLS_ERR_SYNTAX;
+		}
+		if(*tok == ';') {
+			return DLS_OK;
+		}
+	}
+}
+
+/*
+ * Function: parseUnary
+ *
+ * Reads a negation, a parenthesized expression or a net
+ *
+ * dest: Net to drive with the value, -1 to return it in any net
+ *
+ * returns: The net holding the value, or an error code
+ */
+static int parseUnary(struct importer* im, struct scanner* sc, int dest) {
+	char ch = peekChar(sc);
+	int net;
+	if(ch == '~' || ch == '!') {
+		const char* tok;
+		size_t len;
+		verilogToken(sc, &tok, &len);
+		net = parseUnary(im, sc, -1);
+		if(net < 0) {
+			return net;
+		}
+		if(dest < 0) {
+			return invertNet(im, net);
+		}
+		int rc = addGate(im, OP_NOT, &net, 1, dest);
+		return (rc == DLS_OK) ? dest : rc;
+	}
+	if(ch == '(') {
+		expectToken(sc, '(');
+		net = parseOr(im, sc, dest);
+		if(net >= 0 && !expectToken(sc, ')')) {
+			return DLS_ERR_SYNTAX;
+		}
+		return net;
+	}
+	net = parseNetRef(im, sc);
+	if(net < 0 || dest < 0) {
+		return net;
+	}
+	int rc = addBuffer(im, net, dest);
+	return (rc == DLS_OK) ? dest : rc;
+}
+
+/*
+ * Function: hasOperator
+ *
+ * Looks ahead for op outside parentheses before the expression or the operand
+ * of a looser operator ends
+ *
+ * returns: true if op joins the next operand to more of them
+ */
+static bool hasOperator(const struct scanner* sc, char op) {
+	static const char looser[] = "|^&";
+	struct scanner peek = *sc;
+	const char* tok;
+	size_t len;
+	int depth = 0;
+	while(verilogToken(&peek, &tok, &len)) {
+		if(len != 1) {
+			continue;
+		}
+		if(*tok == '(') {
+			depth++;
+		}
+		else if(*tok == ')' && --depth < 0) {
+			return false;
+		}
+		else if(depth == 0 && (*tok == ';' || *tok == ',')) {
+			return false;
+		}
+		else if(depth == 0 && *tok == op) {
+			return true;
+		}
+		else if(depth == 0 && strchr(looser, *tok) != NULL && strchr(looser, *tok) < strchr(looser, op)) {
+			return false;
+		}
+	}
+	return false;
+}
+
+/*
+ * Function: parseBinary
+ *
+ * Reads operands joined by one operator into a single variadic gate
+ * & binds tighter than ^, which binds tighter than |
+ *
+ * op: The operator character
+ *
+ * oper: The gate it becomes
+ *
+ * next: Parser of the operands
+ *
+ * returns: The net holding the value, or an error code
+ */
+static int parseBinary(struct importer* im, struct scanner* sc, int dest, char op, int oper,
+		int (*next)(struct importer*, struct scanner*, int)) {
+	if(!hasOperator(sc, op)) {
+		return next(im, sc, dest);
+	}
+	int cap = 4;
+	int count = 0;
+	int* operands = malloc(cap*sizeof(int));
+	int rc = (operands == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+	do {
+		if(count > 0) {
+			const char* tok;
+			size_t len;
+			verilogToken(sc, &tok, &len);
+		}
+		int net = next(im, sc, -1);
+		rc = (net < 0) ? net : appendNet(&operands, &count, &cap, net);
+	} while(rc == DLS_OK && peekChar(sc) == op);
+	int out = dest;
+	if(rc == DLS_OK && out < 0) {
+		out = tempNet(im);
+		rc = (out < 0) ? out : DLS_OK;
+	}
+	if(rc == DLS_OK) {
+		rc = addGate(im, oper, operands, count, out);
+	}
+	free(operands);
+	return (rc == DLS_OK) ? out : rc;
+}
+
+static int parseAnd(struct importer* im, struct scanner* sc, int dest) {
+	return parseBinary(im, sc, dest, '&', OP_AND, parseUnary);
+}
+
+static int parseXor(struct importer* im, struct scanner* sc, int dest) {
+	return parseBinary(im, sc, dest, '^', OP_XOR, parseAnd);
+}
+
+static int parseOr(struct importer* im, struct scanner* sc, int dest) {
+	return parseBinary(im, sc, dest, '|', OP_OR, parseXor);
+}
+
+/*
+ * Function: parseAssign
+ *
+ * Reads "lhs = expression" pairs up to the semicolon of a continuous assignment
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parseAssign(struct importer* im, struct scanner* sc) {
+	for(;;) {
+		int lhs = parseNetRef(im, sc);
+		if(lhs < 0) {
+			return lhs;
+		}
+		if(!expectToken(sc, '=')) {
+			return DLS_ERR_SYNTAX;
+		}
+		int net = parseOr(im, sc, lhs);
+		if(net < 0) {
+			return net;
+		}
+		const char* tok;
+		size_t len;
+		if(!verilogToken(sc, &tok, &len) || len != 1 || (*tok != ',' && *tok != ';')) {
+			return DLS_ERR_SYNTAX;
+		}
+		if(*tok == ';') {
+			return DLS_OK;
+		}
+	}
+}
+
+/*
+ * Function: parsePrimitive
+ *
+ * Reads the instances of a gate primitive up to the semicolon
+ *	and|or|nand|nor|xor|xnor [name] (out, in1, in2, ...)
+ *	not|buf [name] (out1, ..., outk, in)
+ * An instance of dff takes (clock, q, d) as in the ISCAS-89 netlists
+ *
+ * oper: The gate, -1 for buf and -2 for dff
+ *
+ * returns: DLS_OK or an error code
+ */
+static int parsePrimitive(struct importer* im, struct scanner* sc, int oper) {
+	const char* tok;
+	size_t len;
+	for(;;) {
+		if(peekChar(sc) == '#') { //Delay, ignored
+			verilogToken(sc, &tok, &len);
+			if(peekChar(sc) == '(') {
+				while(verilogToken(sc, &tok, &len) && *tok != ')') {
+				}
+			}
+			else {
+				verilogToken(sc, &tok, &len);
+			}
+		}
+		if(peekChar(sc) != '(') { //Instance name
+			verilogToken(sc, &tok, &len);
+		}
+		if(!expectToken(sc, '(')) {
+			return DLS_ERR_SYNTAX;
+		}
+		im->num_ids = 0;
+		for(;;) {
+			int net = parseNetRef(im, sc);
+			if(net < 0 || appendNet(&im->ids, &im->num_ids, &im->cap_ids, net) != DLS_OK) {
+				return (net < 0) ? net : DLS_ERR_NOMEM;
+			}
+			if(!verilogToken(sc, &tok, &len) || len != 1 || (*tok != ',' && *tok != ')')) {
+				return DLS_ERR_SYNTAX;
+			}
+			if(*tok == ')') {
+				break;
+			}
+		}
+		int n = im->num_ids;
+		int rc = DLS_OK;
+		if(oper == -2) {
+			struct reg* r = (n == 3) ? newReg(im->c) : NULL;
+			if(r == NULL) {
+				return (n == 3) ? DLS_ERR_NOMEM : DLS_ERR_SYNTAX;
+			}
+			r->q = im->ids[1];
+			r->d = im->ids[2];
+			r->rst = -1;
+		}
+		else if(oper == OP_NOT || oper == -1) {
+			for(int o = 0; o < n - 1 && rc == DLS_OK; o++) {
+				rc = (oper == OP_NOT) ? addGate(im, OP_NOT, &im->ids[n - 1], 1, im->ids[o]) : addBuffer(im, im->ids[n - 1], im->ids[o]);
+			}
+			if(n < 2) {
+				rc = DLS_ERR_SYNTAX;
+			}
+		}
+		else if(n == 2) { //One input
+			rc = (oper == OP_AND || oper == OP_OR || oper == OP_XOR) ? addBuffer(im, im->ids[1], im->ids[0]) :
+					addGate(im, OP_NOT, &im->ids[1], 1, im->ids[0]);
+		}
+		else if(n > 2) {
+			rc = addGate(im, oper, &im->ids[1], n - 1, im->ids[0]);
+		}
+		else {
+			rc = DLS_ERR_SYNTAX;
+		}
+		if(rc != DLS_OK) {
+			return rc;
+		}
+		if(!verilogToken(sc, &tok, &len) || len != 1 || (*tok != ',' && *tok != ';')) {
+			return DLS_ERR_SYNTAX;
+		}
+		if(*tok == ';') {
+			return DLS_OK;
+		}
+	}
+}
+
+/*
+ * Structure: primitive
+ *
+ * Keyword table of the Verilog gate primitives
+ *
+ */
+struct primitive {
+	const char* keyword;
+	int oper;
+};
+
+static const struct primitive primitives[] = {
+	{"and", OP_AND},
+	{"or", OP_OR},
+	{"nand", OP_NAND},
+	{"nor", OP_NOR},
+	{"xor", OP_XOR},
+	{"xnor", OP_XNOR},
+	{"not", OP_NOT},
+	{"buf", -1},
+	{"dff", -2},
+	{"DFF", -2},
+};
+
+/*
+ * Function: dlsLoadVerilog
+ *
+ * Parses the first module of a gate-level Verilog netlist
+ * The module may declare input, output and wire nets, scalar or with a [msb:lsb]
+ * range whose bits are named "bus[bit]". The body may instantiate the gate
+ * primitives and ISCAS-89 style dff cells, and use continuous assignments built
+ * from ~, &, ^, | and parentheses over nets and the constants 1'b0 and 1'b1.
+ * Instances of other modules are not supported.
+ *
+ * out: Set to the loaded circuit on success, NULL otherwise
+ *
+ * buf: The netlist, need not be NUL terminated
+ *
+ * len: Length of buf in bytes
+ *
+ * returns: DLS_OK or an error code
+ */
+int dlsLoadVerilog(struct dls_circuit** out, const char* buf, size_t len) {
+	*out = NULL;
+	struct importer im;
+	int rc = newImporter(&im);
+	struct scanner sc = {buf, buf + len};
+	const char* tok;
+	size_t toklen;
+	if(rc == DLS_OK && (!verilogToken(&sc, &tok, &toklen) || !tokenIs(tok, toklen, "module"))) {
+		rc = DLS_ERR_SYNTAX;
+	}
+	while(rc == DLS_OK && verilogToken(&sc, &tok, &toklen) && *tok != ';') { //Name and port list
+	}
+	bool ended = false;
+	while(rc == DLS_OK && !ended) {
+		if(!verilogToken(&sc, &tok, &toklen)) {
+			rc = DLS_ERR_SYNTAX; //No endmodule
+			break;
+		}
+		if(tokenIs(tok, toklen, "endmodule")) {
+			ended = true;
+		}
+		else if(tokenIs(tok, toklen, "input")) {
+			rc = parseDeclaration(&im, &sc, &im.c->inputs, &im.c->num_inputs, &im.cap_inputs);
+		}
+		else if(tokenIs(tok, toklen, "output")) {
+			rc = parseDeclaration(&im, &sc, &im.c->outputs, &im.c->num_outputs, &im.cap_outputs);
+		}
+		else if(tokenIs(tok, toklen, "wire")) {
+			rc = parseDeclaration(&im, &sc, NULL, NULL, NULL);
+		}
+		else if(tokenIs(tok, toklen, "assign")) {
+			rc = parseAssign(&im, &sc);
+		}
+		else {
+			rc = DLS_ERR_SYNTAX;
+			for(size_t i = 0; i < sizeof(primitives)/sizeof(primitives[0]); i++) {
+				if(tokenIs(tok, toklen, primitives[i].keyword)) {
+					rc = parsePrimitive(&im, &sc, primitives[i].oper);
+					break;
+				}
+			}
+		}
+	}
+	return finishImport(&im, rc, out);
+}
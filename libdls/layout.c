@@ -0,0 +1,128 @@
+#include<stdlib.h>
+#include "dls_internal.h"
+
+/*
+ * Cache-aware layout of a compiled circuit
+ *
+ * The parser numbers nets and gates in file order, so evaluating in level order
+ * jumps around both the net words and the gate records. After levelizing, the gates
+ * are moved into level order, grouped by opcode within a level, and their pins are
+ * rewritten in the same order. The nets are given new slots in the order they are
+ * written: constants, inputs, flip-flops, then the outputs of each level, so the
+ * values one level produces sit right before the reads of the next one.
+ * Net ids seen through the API keep the file order; net_slot and slot_net map
+ * between the two numberings.
+ */
+
+/*
+ * Function: assignSlot
+ *
+ * Gives a net the next free slot unless it already has one
+ *
+ */
+static void assignSlot(struct dls_circuit* c, int net, int* next) {
+	if(c->net_slot[net] == -1) {
+		c->net_slot[net] = *next;
+		c->slot_net[*next] = net;
+		(*next)++;
+	}
+}
+
+/*
+ * Function: layoutCircuit
+ *
+ * Reorders the gates, pins and net slots of a levelized circuit
+ * Leaves order as the identity, since the gates are then stored in level order
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+int layoutCircuit(struct dls_circuit* c) {
+	int n = c->num_gates;
+	int* sorted = malloc((n + 1)*sizeof(int));
+	struct gate* gates = malloc((n + 1)*sizeof(struct gate));
+	int* pins = malloc((c->num_pins + 1)*sizeof(int));
+	c->net_slot = malloc(c->num_nets*sizeof(int));
+	c->slot_net = malloc(c->num_nets*sizeof(int));
+	if(sorted == NULL || gates == NULL || pins == NULL || c->net_slot == NULL || c->slot_net == NULL) {
+		free(sorted);
+		free(gates);
+		free(pins);
+		return DLS_ERR_NOMEM;
+	}
+	/*Counting sort of every level by opcode, stable so file order breaks ties*/
+	for(int l = 1; l <= c->num_levels; l++) {
+		int first = c->level_start[l - 1];
+		int last = c->level_start[l];
+		int start[OP_DEAD + 2] = {0};
+		for(int k = first; k < last; k++) {
+			start[c->gates[c->order[k]].oper + 1]++;
+		}
+		for(int op = 0; op <= OP_DEAD; op++) {
+			start[op + 1] += start[op];
+		}
+		for(int k = first; k < last; k++) {
+			int g = c->order[k];
+			sorted[first + start[c->gates[g].oper]++] = g;
+		}
+	}
+	/*Slots in the order the nets are written*/
+	for(int i = 0; i < c->num_nets; i++) {
+		c->net_slot[i] = -1;
+	}
+	int next = 0;
+	assignSlot(c, NET_ZERO, &next);
+	assignSlot(c, NET_ONE, &next);
+	for(int i = 0; i < c->num_inputs; i++) {
+		assignSlot(c, c->inputs[i], &next);
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		assignSlot(c, c->regs[r].q, &next);
+	}
+	for(int k = 0; k < n; k++) {
+		const struct gate* g = &c->gates[sorted[k]];
+		for(int o = 0; o < g->num_outputs; o++) {
+			assignSlot(c, g->outputs[o], &next);
+		}
+	}
+	for(int i = 0; i < c->num_nets; i++) { //Nets nothing writes or reads
+		assignSlot(c, i, &next);
+	}
+	/*Gates and pins in level order, rewritten to slots*/
+	int p = 0;
+	for(int k = 0; k < n; k++) {
+		const struct gate* g = &c->gates[sorted[k]];
+		int num_pins = g->num_inputs + g->num_outputs + (g->oper == OP_MULTIPLEXER ? (1 << g->num_inputs) : 0);
+		for(int i = 0; i < num_pins; i++) {
+			pins[p + i] = c->net_slot[c->pins[g->pin + i]];
+		}
+		gates[k] = *g;
+		gates[k].pin = p;
+		p += num_pins;
+	}
+	free(c->gates);
+	free(c->pins);
+	c->gates = gates;
+	c->cap_gates = n + 1;
+	c->pins = pins;
+	c->num_pins = p;
+	c->cap_pins = c->num_pins + 1;
+	for(int k = 0; k < n; k++) {
+		linkPins(c, &c->gates[k]);
+		c->order[k] = k;
+	}
+	for(int i = 0; i < c->num_inputs; i++) {
+		c->inputs[i] = c->net_slot[c->inputs[i]];
+	}
+	for(int i = 0; i < c->num_outputs; i++) {
+		c->outputs[i] = c->net_slot[c->outputs[i]];
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		c->regs[r].d = c->net_slot[c->regs[r].d];
+		c->regs[r].q = c->net_slot[c->regs[r].q];
+		if(c->regs[r].rst != -1) {
+			c->regs[r].rst = c->net_slot[c->regs[r].rst];
+		}
+	}
+	free(sorted);
+	return DLS_OK;
+}
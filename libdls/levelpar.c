@@ -0,0 +1,335 @@
+#define _POSIX_C_SOURCE 200809L
+#include<stdlib.h>
+#include<pthread.h>
+#include<sched.h>
+#include<stdatomic.h>
+#include<unistd.h>
+#include "dls_internal.h"
+
+/*
+ * Level-parallel evaluation inside one word
+ *
+ * Gates of the same level never read each other's outputs, so a level can be split
+ * among threads. A persistent pool runs the levels as stages separated by a spinning
+ * barrier. Levels too narrow to pay for a barrier are merged with their neighbours
+ * into serial stages run by the calling thread alone.
+ */
+
+/*A level is split among threads when it has at least this many gates per thread*/
+#define MIN_GATES_PER_THREAD 32
+
+/*Barrier spins before yielding the processor*/
+#define SPIN_LIMIT 1024
+
+/*
+ * Structure: stage
+ *
+ * A run of gates in level order
+ *
+ * first, last: order[first] to order[last-1] are the gates of the stage
+ *
+ * parallel: True if the gates are split among all threads, false if the
+ *	calling thread runs the whole stage
+ *
+ */
+struct stage {
+	int first;
+	int last;
+	bool parallel;
+};
+
+/*
+ * Structure: spinbarrier
+ *
+ * Barrier for a fixed number of threads, released by bumping the generation
+ *
+ */
+struct spinbarrier {
+	atomic_int count;
+	atomic_int generation;
+	int total;
+};
+
+/*
+ * Structure: dls_pool
+ *
+ * Persistent worker threads bound to one compiled circuit
+ *
+ * job: Incremented for every word to evaluate, workers wait for it to change
+ *
+ * state: The state being evaluated by the current job
+ *
+ */
+struct dls_pool {
+	const struct dls_circuit* circuit;
+	struct stage* stages;
+	int num_stages;
+	int num_threads;
+	pthread_t* tids;
+	uint64_t** scratch;
+	struct spinbarrier barrier;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	long job;
+	bool quit;
+	struct dls_state* state;
+};
+
+/*
+ * Structure: poolworker
+ *
+ * Arguments of one worker thread
+ *
+ */
+struct poolworker {
+	struct dls_pool* pool;
+	int index;
+};
+
+/*
+ * Function: barrierWait
+ *
+ * Waits until every thread of the pool has arrived
+ *
+ */
+static void barrierWait(struct spinbarrier* b) {
+	int gen = atomic_load(&b->generation);
+	if(atomic_fetch_add(&b->count, 1) == b->total - 1) {
+		atomic_store(&b->count, 0);
+		atomic_fetch_add(&b->generation, 1);
+		return;
+	}
+	int spins = 0;
+	while(atomic_load(&b->generation) == gen) {
+		if(++spins > SPIN_LIMIT) {
+			sched_yield();
+		}
+	}
+}
+
+/*
+ * Function: runStages
+ *
+ * Evaluates one thread's share of every stage of the current job
+ *
+ * t: Index of the thread, 0 for the caller
+ *
+ */
+static void runStages(struct dls_pool* pool, int t) {
+	const struct dls_circuit* c = pool->circuit;
+	struct dls_state* s = pool->state;
+	uint64_t* v = s->nets;
+	int threads = pool->num_threads;
+	for(int k = 0; k < pool->num_stages; k++) {
+		const struct stage* st = &pool->stages[k];
+		if(st->parallel) {
+			int width = st->last - st->first;
+			int first = st->first + (int)((long)width*t/threads);
+			int last = st->first + (int)((long)width*(t + 1)/threads);
+			for(int i = first; i < last; i++) {
+				evalGate(&c->gates[c->order[i]], v, pool->scratch[t]);
+			}
+		}
+		else if(t == 0) {
+			for(int i = st->first; i < st->last; i++) {
+				const struct gate* g = &c->gates[c->order[i]];
+				if(g->oper == OP_INSTANCE) {
+					evalInstance(g, v, s->subs);
+				}
+				else {
+					evalGate(g, v, s->scratch);
+				}
+			}
+		}
+		if(threads > 1) {
+			barrierWait(&pool->barrier);
+		}
+	}
+}
+
+/*
+ * Function: poolWorker
+ *
+ * Thread body, runs every job posted to the pool until told to quit
+ *
+ */
+static void* poolWorker(void* arg) {
+	struct poolworker* w = arg;
+	struct dls_pool* pool = w->pool;
+	long seen = 0;
+	for(;;) {
+		pthread_mutex_lock(&pool->lock);
+		while(pool->job == seen && !pool->quit) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		seen = pool->job;
+		bool quit = pool->quit;
+		pthread_mutex_unlock(&pool->lock);
+		if(quit) {
+			break;
+		}
+		runStages(pool, w->index);
+	}
+	free(w);
+	return NULL;
+}
+
+/*
+ * Function: buildStages
+ *
+ * Turns the levels into stages, merging consecutive narrow levels into one serial stage
+ * Levels holding module instances are serial, since instances of one module share a state
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int buildStages(struct dls_pool* pool) {
+	const struct dls_circuit* c = pool->circuit;
+	pool->stages = malloc((c->num_levels + 1)*sizeof(struct stage));
+	if(pool->stages == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	pool->num_stages = 0;
+	for(int l = 1; l <= c->num_levels; l++) {
+		int first = c->level_start[l - 1];
+		int last = c->level_start[l];
+		bool parallel = pool->num_threads > 1 && last - first >= MIN_GATES_PER_THREAD*pool->num_threads;
+		for(int i = first; i < last && parallel; i++) {
+			if(c->gates[c->order[i]].oper == OP_INSTANCE) {
+				parallel = false;
+			}
+		}
+		struct stage* prev = pool->num_stages ? &pool->stages[pool->num_stages - 1] : NULL;
+		if(!parallel && prev != NULL && !prev->parallel) {
+			prev->last = last; //Merge with the previous narrow levels
+			continue;
+		}
+		struct stage* st = &pool->stages[pool->num_stages++];
+		st->first = first;
+		st->last = last;
+		st->parallel = parallel;
+	}
+	return DLS_OK;
+}
+
+/*
+ * Function: dlsPoolNew
+ *
+ * Starts a pool of threads for level-parallel evaluation of one circuit
+ *
+ * c: The compiled circuit
+ *
+ * threads: Number of threads including the caller, 0 for one per online processor
+ *
+ * returns: The pool, or NULL if the circuit is not compiled or out of resources
+ */
+struct dls_pool* dlsPoolNew(const struct dls_circuit* c, int threads) {
+	if(c == NULL || !c->compiled) {
+		return NULL;
+	}
+	if(threads <= 0) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(threads < 1) {
+		threads = 1;
+	}
+	struct dls_pool* pool = calloc(1, sizeof(struct dls_pool));
+	if(pool == NULL) {
+		return NULL;
+	}
+	pool->circuit = c;
+	pool->num_threads = threads;
+	pool->tids = malloc(threads*sizeof(pthread_t));
+	pool->scratch = calloc(threads, sizeof(uint64_t*));
+	if(pool->tids == NULL || pool->scratch == NULL || buildStages(pool) != DLS_OK) {
+		free(pool->tids);
+		free(pool->scratch);
+		free(pool->stages);
+		free(pool);
+		return NULL;
+	}
+	for(int t = 0; t < threads; t++) {
+		pool->scratch[t] = malloc(c->scratch_words*sizeof(uint64_t));
+	}
+	atomic_init(&pool->barrier.count, 0);
+	atomic_init(&pool->barrier.generation, 0);
+	pool->barrier.total = threads;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	int started = 1;
+	for(int t = 1; t < threads && pool->scratch[t] != NULL; t++) {
+		struct poolworker* w = malloc(sizeof(struct poolworker));
+		if(w == NULL) {
+			break;
+		}
+		w->pool = pool;
+		w->index = t;
+		if(pthread_create(&pool->tids[t], NULL, poolWorker, w) != 0) {
+			free(w);
+			break;
+		}
+		started++;
+	}
+	if(started < threads || pool->scratch[0] == NULL) {
+		for(int t = started; t < threads; t++) {
+			free(pool->scratch[t]);
+		}
+		pool->num_threads = started; //Only join the threads that exist
+		dlsPoolFree(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+/*
+ * Function: dlsPoolFree
+ *
+ * Stops the pool's threads and releases it
+ *
+ */
+void dlsPoolFree(struct dls_pool* pool) {
+	if(pool == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for(int t = 1; t < pool->num_threads; t++) {
+		pthread_join(pool->tids[t], NULL);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->wake);
+	for(int t = 0; t < pool->num_threads; t++) {
+		free(pool->scratch[t]);
+	}
+	free(pool->scratch);
+	free(pool->tids);
+	free(pool->stages);
+	free(pool);
+}
+
+int dlsPoolNumStages(const struct dls_pool* pool) {
+	return pool->num_stages;
+}
+
+/*
+ * Function: dlsPoolEval
+ *
+ * Same as dlsEvalWords, with every wide level split among the pool's threads
+ * Only one word may be evaluated by a pool at a time
+ *
+ * pool: A pool created for the state's circuit
+ *
+ * s: The state, inputs already set
+ *
+ */
+void dlsPoolEval(struct dls_pool* pool, struct dls_state* s) {
+	pool->state = s;
+	if(pool->num_threads > 1) {
+		pthread_mutex_lock(&pool->lock);
+		pool->job++;
+		pthread_cond_broadcast(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+	}
+	runStages(pool, 0);
+}
@@ -0,0 +1,201 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Hierarchical circuits
+ *
+ * A MODULE is parsed and compiled once into a template. Instances are gates that
+ * copy their input words into the template's state, evaluate the template and copy
+ * the outputs back, so memory stays proportional to the unique logic. Flattening
+ * replaces instances by renamed copies of the template's gates.
+ */
+
+/*
+ * Function: mapNet
+ *
+ * Translates a template net into the parent circuit, creating "instance/name"
+ * for nets internal to the instance
+ *
+ * map: Template slot to parent net id, -1 until first used
+ *
+ * id: Slot of the net in the compiled template
+ *
+ * returns: The parent net id, or DLS_ERR_NOMEM
+ */
+static int mapNet(struct dls_circuit* c, const struct dls_circuit* m, int* map, const char* prefix, int id) {
+	if(map[id] != -1) {
+		return map[id];
+	}
+	const char* local = netName(m, slotNet(m, id));
+	size_t plen = strlen(prefix);
+	size_t nlen = strlen(local);
+	char* name = malloc(plen + nlen + 2);
+	if(name == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	memcpy(name, prefix, plen);
+	name[plen] = '/';
+	memcpy(name + plen + 1, local, nlen + 1);
+	map[id] = intern(c, name, plen + nlen + 1);
+	free(name);
+	return map[id];
+}
+
+/*
+ * Function: expandInstance
+ *
+ * Appends a renamed copy of an instance's template gates and flip-flops
+ * Instances inside the template are copied as instances, named "instance/inner"
+ *
+ * gi: Index of the instance gate, left in place for the caller to remove
+ *
+ * returns: DLS_OK or an error code
+ */
+static int expandInstance(struct dls_circuit* c, int gi) {
+	const struct dls_circuit* m = c->gates[gi].sub;
+	const char* prefix = c->inst_names[c->gates[gi].inst];
+	int pin = c->gates[gi].pin;
+	int* map = malloc(m->num_nets*sizeof(int));
+	if(map == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	for(int i = 0; i < m->num_nets; i++) {
+		map[i] = -1;
+	}
+	map[NET_ZERO] = NET_ZERO;
+	map[NET_ONE] = NET_ONE;
+	int rc = DLS_OK;
+	for(int i = 0; i < m->num_inputs; i++) {
+		map[m->inputs[i]] = c->pins[pin + i];
+	}
+	for(int o = 0; o < m->num_outputs && rc == DLS_OK; o++) {
+		if(map[m->outputs[o]] != -1) { //Output wired straight to an input or constant
+			rc = DLS_ERR_MULTIDRIVEN;
+		}
+		map[m->outputs[o]] = c->pins[pin + m->num_inputs + o];
+	}
+	for(int k = 0; k < m->num_gates && rc == DLS_OK; k++) {
+		const struct gate* mg = &m->gates[k];
+		int num_pins = mg->num_inputs + mg->num_outputs + (mg->oper == OP_MULTIPLEXER ? (1 << mg->num_inputs) : 0);
+		struct gate* g = newGate(c, mg->oper, mg->num_inputs, mg->num_outputs);
+		if(g == NULL) {
+			rc = DLS_ERR_NOMEM;
+			break;
+		}
+		g->sub = mg->sub;
+		for(int p = 0; p < num_pins && rc == DLS_OK; p++) {
+			int net = mapNet(c, m, map, prefix, m->pins[mg->pin + p]);
+			if(net < 0) {
+				rc = net;
+			}
+			else {
+				c->pins[g->pin + p] = net;
+			}
+		}
+		if(mg->oper == OP_INSTANCE && rc == DLS_OK) {
+			size_t plen = strlen(prefix);
+			size_t ilen = strlen(m->inst_names[mg->inst]);
+			char* name = malloc(plen + ilen + 2);
+			if(name == NULL) {
+				rc = DLS_ERR_NOMEM;
+				break;
+			}
+			memcpy(name, prefix, plen);
+			name[plen] = '/';
+			memcpy(name + plen + 1, m->inst_names[mg->inst], ilen + 1);
+			g->inst = newInstName(c, name, plen + ilen + 1);
+			free(name);
+			if(g->inst < 0) {
+				rc = g->inst;
+			}
+		}
+	}
+	for(int r = 0; r < m->num_regs && rc == DLS_OK; r++) {
+		const struct reg* mr = &m->regs[r];
+		int d = mapNet(c, m, map, prefix, mr->d);
+		int q = mapNet(c, m, map, prefix, mr->q);
+		int rst = (mr->rst == -1) ? -1 : mapNet(c, m, map, prefix, mr->rst);
+		struct reg* nr = newReg(c);
+		if(d < 0 || q < 0 || (mr->rst != -1 && rst < 0) || nr == NULL) {
+			rc = DLS_ERR_NOMEM;
+			break;
+		}
+		nr->d = d;
+		nr->q = q;
+		nr->rst = rst;
+	}
+	free(map);
+	return rc;
+}
+
+/*
+ * Function: flattenInstances
+ *
+ * Replaces instances by copies of their templates, repeating on the copies
+ * until no selected instance is left
+ *
+ * only_regs: Only flatten instances of modules holding flip-flops
+ *
+ * returns: DLS_OK or an error code
+ */
+int flattenInstances(struct dls_circuit* c, bool only_regs) {
+	int rc = DLS_OK;
+	for(int i = 0; i < c->num_gates && rc == DLS_OK; i++) { //Copies are appended and visited too
+		if(c->gates[i].oper != OP_INSTANCE || (only_regs && !c->gates[i].sub->has_regs)) {
+			continue;
+		}
+		rc = expandInstance(c, i);
+		c->gates[i].oper = OP_DEAD;
+	}
+	int n = 0;
+	for(int i = 0; i < c->num_gates; i++) {
+		if(c->gates[i].oper != OP_DEAD) {
+			c->gates[n++] = c->gates[i];
+		}
+	}
+	c->num_gates = n;
+	return rc;
+}
+
+/*
+ * Function: dlsFlatten
+ *
+ * Expands every instance into renamed copies of its module's gates, so that
+ * engines see a flat netlist where internal nets are named "instance/net"
+ * Must be called before dlsCompile
+ *
+ * returns: DLS_OK, DLS_ERR_STATE if the circuit is already compiled, or an error code
+ */
+int dlsFlatten(struct dls_circuit* c) {
+	if(c == NULL) {
+		return DLS_ERR_ARG;
+	}
+	if(c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	return flattenInstances(c, false);
+}
+
+/*
+ * Function: evalInstance
+ *
+ * Evaluates one instance through its template's shared state
+ *
+ * v: Net words of the circuit holding the instance
+ *
+ * subs: Module states of the top level circuit
+ *
+ */
+void evalInstance(const struct gate* g, uint64_t* v, struct dls_state** subs) {
+	const struct dls_circuit* m = g->sub;
+	struct dls_state* sub = subs[m->module_index];
+	uint64_t* sv = sub->nets;
+	for(int i = 0; i < m->num_inputs; i++) {
+		sv[m->inputs[i]] = v[g->inputs[i]];
+	}
+	evalNets(m, sv, sub->scratch, subs);
+	for(int o = 0; o < m->num_outputs; o++) {
+		v[g->outputs[o]] = sv[m->outputs[o]];
+	}
+}
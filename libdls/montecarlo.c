@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 200809L
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include<stdatomic.h>
+#include<unistd.h>
+#include "dls_internal.h"
+
+/*
+ * Monte-Carlo simulation with random vectors
+ *
+ * Input word i of vector word w is a pure function of the seed and the counter
+ * w*num_inputs + i, hashed with the splitmix64 finalizer. Any word can be drawn
+ * without drawing the ones before it, so threads take words in any order and the
+ * results only depend on the seed and the number of vectors.
+ */
+
+/*Words handed to a thread at a time*/
+#define WORDS_PER_CHUNK 64
+
+/*
+ * Structure: mcjob
+ *
+ * Work shared by the Monte-Carlo threads
+ *
+ * next_chunk: Next chunk of words to hand out
+ *
+ * ones: Per-output count of vectors with the output at 1, added to under lock
+ *
+ */
+struct mcjob {
+	const struct dls_circuit* circuit;
+	uint64_t seed;
+	uint64_t count;
+	uint64_t words;
+	atomic_ullong next_chunk;
+	pthread_mutex_t lock;
+	uint64_t* ones;
+	atomic_int rc;
+};
+
+/*
+ * Function: randomWord
+ *
+ * returns: 64 random bits for a counter, from the splitmix64 finalizer
+ */
+static uint64_t randomWord(uint64_t seed, uint64_t counter) {
+	uint64_t z = seed + (counter + 1)*0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+/*
+ * Function: dlsSetRandomInputs
+ *
+ * Sets the inputs to vector word w of the random stream of a seed
+ * Vector 64*w+k is lane k
+ *
+ */
+void dlsSetRandomInputs(struct dls_state* s, uint64_t seed, uint64_t w) {
+	const struct dls_circuit* c = s->circuit;
+	uint64_t counter = w*c->num_inputs;
+	for(int i = 0; i < c->num_inputs; i++) {
+		s->nets[c->inputs[i]] = randomWord(seed, counter + i);
+	}
+}
+
+/*
+ * Function: mcWorker
+ *
+ * Thread body, evaluates chunks of words until none are left
+ *
+ */
+static void* mcWorker(void* arg) {
+	struct mcjob* job = arg;
+	const struct dls_circuit* c = job->circuit;
+	int no = c->num_outputs;
+	struct dls_state* s = dlsStateNew(c);
+	uint64_t* ones = calloc(no + 1, sizeof(uint64_t));
+	if(s == NULL || ones == NULL) {
+		atomic_store(&job->rc, DLS_ERR_NOMEM);
+		dlsStateFree(s);
+		free(ones);
+		return NULL;
+	}
+	uint64_t chunk;
+	while((chunk = atomic_fetch_add(&job->next_chunk, 1))*WORDS_PER_CHUNK < job->words) {
+		uint64_t last = (chunk + 1)*WORDS_PER_CHUNK;
+		if(last > job->words) {
+			last = job->words;
+		}
+		for(uint64_t w = chunk*WORDS_PER_CHUNK; w < last; w++) {
+			dlsSetRandomInputs(s, job->seed, w);
+			dlsEvalWords(c, s);
+			uint64_t lanes = job->count - w*64;
+			uint64_t mask = (lanes >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << lanes) - 1);
+			for(int o = 0; o < no; o++) {
+				ones[o] += __builtin_popcountll(s->nets[c->outputs[o]] & mask);
+			}
+		}
+	}
+	pthread_mutex_lock(&job->lock);
+	for(int o = 0; o < no; o++) {
+		job->ones[o] += ones[o];
+	}
+	pthread_mutex_unlock(&job->lock);
+	free(ones);
+	dlsStateFree(s);
+	return NULL;
+}
+
+/*
+ * Function: dlsMonteCarlo
+ *
+ * Counts how often each output is 1 over random vectors, flip-flops held at 0
+ * The counts do not depend on the number of threads
+ *
+ * c: The compiled circuit
+ *
+ * seed: Selects the random stream, the same one dlsSetRandomInputs draws from
+ *
+ * count: Number of vectors
+ *
+ * threads: Number of threads, 0 for one per online processor
+ *
+ * ones: dlsNumOutputs counters, set to the number of vectors with each output at 1
+ *
+ * returns: DLS_OK, DLS_ERR_STATE or DLS_ERR_NOMEM
+ */
+int dlsMonteCarlo(const struct dls_circuit* c, uint64_t seed, uint64_t count, int threads, uint64_t* ones) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	struct mcjob job;
+	job.circuit = c;
+	job.seed = seed;
+	job.count = count;
+	job.words = (count + 63)/64;
+	job.ones = ones;
+	atomic_init(&job.next_chunk, 0);
+	atomic_init(&job.rc, DLS_OK);
+	pthread_mutex_init(&job.lock, NULL);
+	memset(ones, 0, c->num_outputs*sizeof(uint64_t));
+	if(threads <= 0) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	uint64_t chunks = (job.words + WORDS_PER_CHUNK - 1)/WORDS_PER_CHUNK;
+	if((uint64_t)threads > chunks) {
+		threads = (int)chunks;
+	}
+	if(threads < 1) {
+		threads = 1;
+	}
+	pthread_t* tids = malloc(threads*sizeof(pthread_t));
+	if(tids == NULL) {
+		pthread_mutex_destroy(&job.lock);
+		return DLS_ERR_NOMEM;
+	}
+	int started = 0;
+	for(int t = 1; t < threads; t++) {
+		if(pthread_create(&tids[t], NULL, mcWorker, &job) != 0) {
+			break;
+		}
+		started++;
+	}
+	mcWorker(&job); //The calling thread works too
+	for(int t = 1; t <= started; t++) {
+		pthread_join(tids[t], NULL);
+	}
+	free(tids);
+	pthread_mutex_destroy(&job.lock);
+	return atomic_load(&job.rc);
+}
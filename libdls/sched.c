@@ -0,0 +1,505 @@
+#define _POSIX_C_SOURCE 200809L
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include<time.h>
+#include<unistd.h>
+#include "dls_internal.h"
+
+/*
+ * Work-stealing evaluation over output cones and vector blocks
+ *
+ * The outputs are grouped into clusters whose fanin cones hold a similar number of
+ * gates, and the vectors into blocks of BLOCK_WORDS words. A task evaluates one
+ * cluster's gates on one block. Every worker owns a deque of tasks: it pops its own
+ * from the bottom and, once empty, steals from the top of the other workers' deques,
+ * so cones of very different sizes still keep every thread busy. Vectors are handled
+ * in rounds of ROUND_BLOCKS blocks, and each round's outputs are handed back in order.
+ */
+
+/*Words of 64 vectors per task*/
+#define BLOCK_WORDS 16
+
+/*Blocks per round*/
+#define ROUND_BLOCKS 64
+
+/*Clusters aim for this many per thread, so there is something to steal*/
+#define CLUSTERS_PER_THREAD 4
+
+/*
+ * Structure: cluster
+ *
+ * A group of outputs and the union of their fanin cones
+ *
+ * gates: Gate indices in level order
+ *
+ * outputs: Output indices computed by the cluster
+ *
+ */
+struct cluster {
+	int* gates;
+	int num_gates;
+	int* outputs;
+	int num_outputs;
+};
+
+/*
+ * Structure: task
+ *
+ * One cluster evaluated on one block of a round
+ *
+ */
+struct task {
+	int cluster;
+	int block;
+};
+
+/*
+ * Structure: deque
+ *
+ * Tasks of one worker, the owner works from the bottom and thieves from the top
+ *
+ */
+struct deque {
+	struct task* tasks;
+	int top;
+	int bottom;
+	pthread_mutex_t lock;
+};
+
+/*
+ * Structure: schedjob
+ *
+ * Everything shared by the workers of one dlsSchedRun call
+ *
+ * round: Incremented for every round, workers wait for it to change
+ *
+ * active: Workers still busy with the current round
+ *
+ * round_first: Index of the first vector of the current round
+ *
+ * round_count: Number of vectors in the current round
+ *
+ * out: Output words of the round, word w of output o at out[w*num_outputs + o]
+ *
+ */
+struct schedjob {
+	const struct dls_circuit* circuit;
+	const unsigned char* vectors;
+	struct cluster* clusters;
+	int num_clusters;
+	struct deque* deques;
+	int num_threads;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	long round;
+	int active;
+	bool done;
+	uint64_t round_first;
+	uint64_t round_count;
+	uint64_t* out;
+	struct dls_sched_stats* stats;
+	int rc;
+};
+
+/*
+ * Structure: schedworker
+ *
+ * Arguments of one worker thread
+ *
+ */
+struct schedworker {
+	struct schedjob* job;
+	int index;
+};
+
+/*
+ * Function: elapsed
+ *
+ * returns: Seconds from a to b
+ */
+static double elapsed(const struct timespec* a, const struct timespec* b) {
+	return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec)*1e-9;
+}
+
+/*
+ * Function: compareInts
+ *
+ * qsort comparison for ints
+ *
+ */
+static int compareInts(const void* a, const void* b) {
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Function: buildClusters
+ *
+ * Collects the fanin cone of every output and packs consecutive outputs together
+ * until their combined cone reaches the target size
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int buildClusters(struct schedjob* job) {
+	const struct dls_circuit* c = job->circuit;
+	int rc = DLS_OK;
+	int* driver = malloc(c->num_nets*sizeof(int));
+	int* rank = malloc((c->num_gates + 1)*sizeof(int)); //Position of each gate in the level order
+	int* mark = malloc((c->num_gates + 1)*sizeof(int)); //Cluster that last collected the gate
+	int* stack = malloc((c->num_gates + 1)*sizeof(int));
+	job->clusters = calloc(c->num_outputs + 1, sizeof(struct cluster));
+	if(driver == NULL || rank == NULL || mark == NULL || stack == NULL || job->clusters == NULL) {
+		rc = DLS_ERR_NOMEM;
+		goto done;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		driver[i] = -1;
+	}
+	for(int k = 0; k < c->num_gates; k++) {
+		int g = c->order[k];
+		rank[g] = k;
+		mark[g] = -1;
+		for(int o = 0; o < c->gates[g].num_outputs; o++) {
+			driver[c->gates[g].outputs[o]] = g;
+		}
+	}
+	int target = c->num_gates/(job->num_threads*CLUSTERS_PER_THREAD);
+	struct cluster* cl = NULL;
+	job->num_clusters = 0;
+	for(int o = 0; o < c->num_outputs; o++) {
+		if(cl == NULL || cl->num_gates >= target) {
+			cl = &job->clusters[job->num_clusters++];
+			cl->gates = malloc((c->num_gates + 1)*sizeof(int));
+			cl->outputs = malloc(c->num_outputs*sizeof(int));
+			if(cl->gates == NULL || cl->outputs == NULL) {
+				rc = DLS_ERR_NOMEM;
+				goto done;
+			}
+		}
+		int id = job->num_clusters - 1;
+		cl->outputs[cl->num_outputs++] = o;
+		int sp = 0;
+		if(driver[c->outputs[o]] >= 0 && mark[driver[c->outputs[o]]] != id) {
+			mark[driver[c->outputs[o]]] = id;
+			stack[sp++] = driver[c->outputs[o]];
+		}
+		while(sp > 0) {
+			const struct gate* g = &c->gates[stack[--sp]];
+			cl->gates[cl->num_gates++] = g - c->gates;
+			int fanin = gateNumFanin(g);
+			for(int k = 0; k < fanin; k++) {
+				int d = driver[gateFanin(g, k)];
+				if(d >= 0 && mark[d] != id) {
+					mark[d] = id;
+					stack[sp++] = d;
+				}
+			}
+		}
+	}
+	for(int k = 0; k < job->num_clusters; k++) { //Back into level order
+		struct cluster* cur = &job->clusters[k];
+		for(int i = 0; i < cur->num_gates; i++) {
+			cur->gates[i] = rank[cur->gates[i]];
+		}
+		qsort(cur->gates, cur->num_gates, sizeof(int), compareInts);
+		for(int i = 0; i < cur->num_gates; i++) {
+			cur->gates[i] = c->order[cur->gates[i]];
+		}
+	}
+done:
+	free(driver);
+	free(rank);
+	free(mark);
+	free(stack);
+	return rc;
+}
+
+/*
+ * Function: runTask
+ *
+ * Evaluates one cluster on one block of the current round
+ *
+ */
+static void runTask(struct schedjob* job, struct dls_state* s, const struct task* t) {
+	const struct dls_circuit* c = job->circuit;
+	const struct cluster* cl = &job->clusters[t->cluster];
+	uint64_t* v = s->nets;
+	int ni = c->num_inputs;
+	int no = c->num_outputs;
+	uint64_t words = (job->round_count + 63)/64;
+	for(uint64_t w = (uint64_t)t->block*BLOCK_WORDS; w < (uint64_t)(t->block + 1)*BLOCK_WORDS && w < words; w++) {
+		uint64_t base = job->round_first + w*64;
+		if(job->vectors == NULL) {
+			dlsSetGrayInputs(s, base);
+		}
+		else {
+			uint64_t end = job->round_first + job->round_count;
+			int lanes = (end - base < 64) ? (int)(end - base) : 64;
+			for(int i = 0; i < ni; i++) {
+				uint64_t word = 0;
+				for(int k = 0; k < lanes; k++) {
+					word |= (uint64_t)(job->vectors[(base + k)*ni + i] & 1) << k;
+				}
+				v[c->inputs[i]] = word;
+			}
+		}
+		for(int k = 0; k < cl->num_gates; k++) {
+			const struct gate* g = &c->gates[cl->gates[k]];
+			if(g->oper == OP_INSTANCE) {
+				evalInstance(g, v, s->subs);
+			}
+			else {
+				evalGate(g, v, s->scratch);
+			}
+		}
+		for(int k = 0; k < cl->num_outputs; k++) {
+			int o = cl->outputs[k];
+			job->out[w*no + o] = v[c->outputs[o]];
+		}
+	}
+}
+
+/*
+ * Function: takeTask
+ *
+ * Pops a task from the worker's own deque, or steals one from another worker
+ *
+ * returns: true if a task was found, false when every deque is empty
+ */
+static bool takeTask(struct schedjob* job, int self, struct task* t) {
+	struct deque* d = &job->deques[self];
+	pthread_mutex_lock(&d->lock);
+	bool found = d->bottom > d->top;
+	if(found) {
+		*t = d->tasks[--d->bottom];
+	}
+	pthread_mutex_unlock(&d->lock);
+	if(found) {
+		return true;
+	}
+	for(int k = 1; k < job->num_threads; k++) {
+		struct deque* victim = &job->deques[(self + k) % job->num_threads];
+		pthread_mutex_lock(&victim->lock);
+		found = victim->bottom > victim->top;
+		if(found) {
+			*t = victim->tasks[victim->top++];
+		}
+		pthread_mutex_unlock(&victim->lock);
+		if(found) {
+			job->stats[self].steals++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Function: workRound
+ *
+ * Runs tasks until every deque of the round is empty
+ *
+ */
+static void workRound(struct schedjob* job, int self, struct dls_state* s) {
+	struct task t;
+	struct timespec a, b;
+	while(takeTask(job, self, &t)) {
+		clock_gettime(CLOCK_MONOTONIC, &a);
+		runTask(job, s, &t);
+		clock_gettime(CLOCK_MONOTONIC, &b);
+		job->stats[self].tasks++;
+		job->stats[self].busy_seconds += elapsed(&a, &b);
+	}
+}
+
+/*
+ * Function: schedWorker
+ *
+ * Thread body, works on every round until the job is done
+ *
+ */
+static void* schedWorker(void* arg) {
+	struct schedworker* w = arg;
+	struct schedjob* job = w->job;
+	struct dls_state* s = dlsStateNew(job->circuit);
+	long seen = 0;
+	for(;;) {
+		pthread_mutex_lock(&job->lock);
+		while(job->round == seen && !job->done) {
+			pthread_cond_wait(&job->wake, &job->lock);
+		}
+		seen = job->round;
+		bool done = job->done;
+		pthread_mutex_unlock(&job->lock);
+		if(done) {
+			break;
+		}
+		if(s != NULL) { //Without a state, leave the tasks to the others
+			workRound(job, w->index, s);
+		}
+		pthread_mutex_lock(&job->lock);
+		if(--job->active == 0) {
+			pthread_cond_signal(&job->idle);
+		}
+		pthread_mutex_unlock(&job->lock);
+	}
+	dlsStateFree(s);
+	free(w);
+	return NULL;
+}
+
+/*
+ * Function: dlsSchedRun
+ *
+ * Evaluates a vector sequence with the work-stealing scheduler
+ * Rounds of outputs are passed to emit in vector order, from the calling thread
+ *
+ * c: The compiled circuit
+ *
+ * vectors: Rows of dlsNumInputs bytes, 0 or 1
+ *	NULL for the input combinations of the gray code sweep
+ *
+ * first: Index of the first vector, a multiple of 64 for the sweep
+ *
+ * count: Number of vectors
+ *
+ * threads: Number of threads including the caller, 0 for one per online processor
+ *
+ * emit: Called with the index of the round's first vector, its number of vectors and
+ *	the output words, word w of output o at out[w*dlsNumOutputs + o]
+ *
+ * ctx: Passed to emit
+ *
+ * stats: NULL, or one entry per thread to fill with its counters
+ *	The number of entries is dlsSchedThreads(threads)
+ *
+ * returns: DLS_OK, DLS_ERR_STATE, DLS_ERR_ARG if the rows are not in the sweep, or DLS_ERR_NOMEM
+ */
+int dlsSchedRun(const struct dls_circuit* c, const unsigned char* vectors, uint64_t first, uint64_t count, int threads,
+		void (*emit)(void*, uint64_t, uint64_t, const uint64_t*), void* ctx, struct dls_sched_stats* stats) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	if(vectors == NULL && (c->num_inputs > 63 || first % 64 != 0 || first > ((uint64_t)1 << c->num_inputs) ||
+			count > ((uint64_t)1 << c->num_inputs) - first)) {
+		return DLS_ERR_ARG;
+	}
+	struct schedjob job;
+	memset(&job, 0, sizeof(job));
+	job.circuit = c;
+	job.vectors = vectors;
+	int requested = dlsSchedThreads(threads);
+	job.num_threads = requested;
+	job.stats = calloc(requested, sizeof(struct dls_sched_stats));
+	job.deques = calloc(requested, sizeof(struct deque));
+	job.out = malloc(((uint64_t)ROUND_BLOCKS*BLOCK_WORDS*c->num_outputs + 1)*sizeof(uint64_t));
+	struct dls_state* s = dlsStateNew(c);
+	pthread_t* tids = malloc(requested*sizeof(pthread_t));
+	int rc = (job.stats == NULL || job.deques == NULL || job.out == NULL || s == NULL || tids == NULL) ? DLS_ERR_NOMEM : buildClusters(&job);
+	for(int t = 0; job.deques != NULL && t < requested; t++) {
+		pthread_mutex_init(&job.deques[t].lock, NULL);
+		if(rc == DLS_OK) {
+			job.deques[t].tasks = malloc((job.num_clusters*ROUND_BLOCKS + 1)*sizeof(struct task));
+			if(job.deques[t].tasks == NULL) {
+				rc = DLS_ERR_NOMEM;
+			}
+		}
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.wake, NULL);
+	pthread_cond_init(&job.idle, NULL);
+	int started = 1;
+	for(int t = 1; t < job.num_threads && rc == DLS_OK; t++) {
+		struct schedworker* w = malloc(sizeof(struct schedworker));
+		if(w == NULL) {
+			break;
+		}
+		w->job = &job;
+		w->index = t;
+		if(pthread_create(&tids[t], NULL, schedWorker, w) != 0) {
+			free(w);
+			break;
+		}
+		started++;
+	}
+	job.num_threads = started; //Deal tasks only to the threads that exist
+	struct timespec begin, finish;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	uint64_t round_vectors = (uint64_t)ROUND_BLOCKS*BLOCK_WORDS*64;
+	for(uint64_t done = 0; rc == DLS_OK && done < count; done += round_vectors) {
+		job.round_first = first + done;
+		job.round_count = (count - done < round_vectors) ? count - done : round_vectors;
+		int blocks = (int)((job.round_count + BLOCK_WORDS*64 - 1)/(BLOCK_WORDS*64));
+		for(int t = 0; t < job.num_threads; t++) {
+			job.deques[t].top = 0;
+			job.deques[t].bottom = 0;
+		}
+		int next = 0;
+		for(int b = 0; b < blocks; b++) { //Deal the tasks out like cards
+			for(int k = 0; k < job.num_clusters; k++) {
+				struct deque* d = &job.deques[next];
+				d->tasks[d->bottom].cluster = k;
+				d->tasks[d->bottom].block = b;
+				d->bottom++;
+				next = (next + 1) % job.num_threads;
+			}
+		}
+		pthread_mutex_lock(&job.lock);
+		job.active = job.num_threads - 1;
+		job.round++;
+		pthread_cond_broadcast(&job.wake);
+		pthread_mutex_unlock(&job.lock);
+		workRound(&job, 0, s);
+		pthread_mutex_lock(&job.lock);
+		while(job.active > 0) {
+			pthread_cond_wait(&job.idle, &job.lock);
+		}
+		pthread_mutex_unlock(&job.lock);
+		emit(ctx, job.round_first, job.round_count, job.out);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	pthread_mutex_lock(&job.lock);
+	job.done = true;
+	pthread_cond_broadcast(&job.wake);
+	pthread_mutex_unlock(&job.lock);
+	for(int t = 1; t < started; t++) {
+		pthread_join(tids[t], NULL);
+	}
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.wake);
+	pthread_cond_destroy(&job.idle);
+	double wall = elapsed(&begin, &finish);
+	for(int t = 0; stats != NULL && job.stats != NULL && t < requested; t++) {
+		stats[t] = job.stats[t];
+		stats[t].utilization = (wall > 0) ? job.stats[t].busy_seconds/wall : 0;
+	}
+	for(int k = 0; job.clusters != NULL && k < job.num_clusters; k++) {
+		free(job.clusters[k].gates);
+		free(job.clusters[k].outputs);
+	}
+	for(int t = 0; job.deques != NULL && t < requested; t++) {
+		free(job.deques[t].tasks);
+		pthread_mutex_destroy(&job.deques[t].lock);
+	}
+	free(job.clusters);
+	free(job.deques);
+	free(job.stats);
+	free(job.out);
+	free(tids);
+	dlsStateFree(s);
+	return rc;
+}
+
+/*
+ * Function: dlsSchedThreads
+ *
+ * returns: The number of threads dlsSchedRun uses for a requested count
+ */
+int dlsSchedThreads(int threads) {
+	if(threads <= 0) {
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	return (threads < 1) ? 1 : threads;
+}
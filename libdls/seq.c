@@ -0,0 +1,92 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Cycle-based sequential simulation
+ *
+ * Each clock cycle evaluates the levelized combinational logic once, then latches
+ * every flip-flop at the same time. The 64 bits of a word are 64 independent
+ * stimulus streams, each with its own register contents.
+ */
+
+int dlsNumRegisters(const struct dls_circuit* c) {
+	return c->num_regs;
+}
+
+/*
+ * Function: dlsResetRegisters
+ *
+ * Clears every flip-flop of a state in all 64 streams
+ *
+ */
+void dlsResetRegisters(struct dls_state* s) {
+	const struct dls_circuit* c = s->circuit;
+	for(int r = 0; r < c->num_regs; r++) {
+		s->nets[c->regs[r].q] = 0;
+	}
+}
+
+/*
+ * Function: dlsClock
+ *
+ * Latches all flip-flops from the current net values
+ * The next states are gathered first, so a flip-flop feeding another one
+ * directly still shifts by exactly one stage
+ *
+ * c: The compiled circuit
+ *
+ * s: A state that has been evaluated with dlsEvalWords for this cycle
+ *
+ */
+void dlsClock(const struct dls_circuit* c, struct dls_state* s) {
+	uint64_t* v = s->nets;
+	const struct reg* regs = c->regs;
+	for(int r = 0; r < c->num_regs; r++) {
+		uint64_t next = v[regs[r].d];
+		if(regs[r].rst != -1) {
+			next &= ~v[regs[r].rst];
+		}
+		s->latch[r] = next;
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		v[regs[r].q] = s->latch[r];
+	}
+}
+
+/*
+ * Function: dlsRunCycles
+ *
+ * Runs a number of clock cycles from a stimulus stream
+ * The outputs of a cycle are sampled after the combinational logic settles and
+ * before the flip-flops are latched
+ *
+ * c: The compiled circuit
+ *
+ * s: The state, holding the register contents to start from
+ *
+ * cycles: Number of clock cycles
+ *
+ * in: cycles*dlsNumInputs words, the input words of cycle k start at in[k*dlsNumInputs]
+ *
+ * out: cycles*dlsNumOutputs words, filled the same way with the output words
+ *	May be NULL if only the final register contents are wanted
+ *
+ */
+void dlsRunCycles(const struct dls_circuit* c, struct dls_state* s, long cycles, const uint64_t* in, uint64_t* out) {
+	uint64_t* v = s->nets;
+	int ni = c->num_inputs;
+	int no = c->num_outputs;
+	for(long k = 0; k < cycles; k++) {
+		for(int i = 0; i < ni; i++) {
+			v[c->inputs[i]] = in[k*ni + i];
+		}
+		dlsEvalWords(c, s);
+		if(out != NULL) {
+			for(int o = 0; o < no; o++) {
+				out[k*no + o] = v[c->outputs[o]];
+			}
+		}
+		dlsClock(c, s);
+	}
+}
@@ -0,0 +1,361 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Support-reduced enumeration
+ *
+ * The structural support of an output is the set of primary inputs in its fanin
+ * cone; no other input can change it. Outputs with the same support form a group,
+ * and each group is swept once over its own inputs, evaluating only the gates of
+ * its cone, into one bit per combination and output. A circuit with many loosely
+ * coupled outputs then costs a few 2^k sweeps instead of one 2^n sweep, and any
+ * row of the full table is a lookup in each group's table.
+ */
+
+/*Widest support a group may have*/
+#define MAX_SUPPORT 40
+
+/*
+ * Structure: group
+ *
+ * Outputs sharing one support, and their table
+ *
+ * inputs: Input indices of the support, in INPUTVAR order; the first is the most
+ *	significant bit of a table index
+ *
+ * outputs: Output indices of the group
+ *
+ * gates: The union of the outputs' fanin cones, in level order
+ *
+ * table: One row of row_words words per output, bit i of a row is the output's
+ *	value when the support inputs spell i
+ *
+ */
+struct group {
+	int* inputs;
+	int num_inputs;
+	int* outputs;
+	int num_outputs;
+	int* gates;
+	int num_gates;
+	uint64_t* table;
+	size_t row_words;
+};
+
+/*
+ * Structure: dls_support
+ *
+ * The support groups of a compiled circuit
+ *
+ * out_group, out_row: Group of each output and its row in the group's table
+ *
+ */
+struct dls_support {
+	const struct dls_circuit* circuit;
+	struct group* groups;
+	int num_groups;
+	int* out_group;
+	int* out_row;
+};
+
+/*
+ * Function: collectSupports
+ *
+ * Works out the support of every slot in level order, as a bitset over the inputs
+ *
+ * words: Words per bitset
+ *
+ * returns: num_nets bitsets of words words, or NULL if out of memory
+ */
+uint64_t* collectSupports(const struct dls_circuit* c, int words) {
+	uint64_t* sup = calloc((size_t)c->num_nets*words + 1, sizeof(uint64_t));
+	if(sup == NULL) {
+		return NULL;
+	}
+	for(int i = 0; i < c->num_inputs; i++) {
+		sup[(size_t)c->inputs[i]*words + i/64] |= (uint64_t)1 << (i % 64);
+	}
+	for(int k = 0; k < c->num_gates; k++) {
+		const struct gate* g = &c->gates[c->order[k]];
+		int fanin = gateNumFanin(g);
+		for(int o = 0; o < g->num_outputs; o++) {
+			uint64_t* dst = &sup[(size_t)g->outputs[o]*words];
+			for(int f = 0; f < fanin; f++) {
+				const uint64_t* src = &sup[(size_t)gateFanin(g, f)*words];
+				for(int w = 0; w < words; w++) {
+					dst[w] |= src[w];
+				}
+			}
+		}
+	}
+	return sup;
+}
+
+/*
+ * Function: buildGroups
+ *
+ * Groups the outputs by support and collects each group's inputs and cone
+ *
+ * returns: DLS_OK, DLS_ERR_ARG if a support is wider than MAX_SUPPORT, or DLS_ERR_NOMEM
+ */
+static int buildGroups(struct dls_support* sp) {
+	const struct dls_circuit* c = sp->circuit;
+	int words = (c->num_inputs + 63)/64 + 1;
+	uint64_t* sup = collectSupports(c, words);
+	int* first = malloc((c->num_outputs + 1)*sizeof(int)); //First output of each group
+	int* driver = malloc(c->num_nets*sizeof(int));
+	char* mark = malloc(c->num_gates + 1);
+	int* stack = malloc((c->num_gates + 1)*sizeof(int));
+	sp->groups = calloc(c->num_outputs + 1, sizeof(struct group));
+	int rc = (sup == NULL || first == NULL || driver == NULL || mark == NULL || stack == NULL || sp->groups == NULL) ? DLS_ERR_NOMEM : DLS_OK;
+	for(int o = 0; o < c->num_outputs && rc == DLS_OK; o++) {
+		const uint64_t* mine = &sup[(size_t)c->outputs[o]*words];
+		int gr = 0;
+		while(gr < sp->num_groups && memcmp(mine, &sup[(size_t)c->outputs[first[gr]]*words], words*sizeof(uint64_t)) != 0) {
+			gr++;
+		}
+		if(gr == sp->num_groups) {
+			first[sp->num_groups++] = o;
+		}
+		sp->out_group[o] = gr;
+		sp->out_row[o] = sp->groups[gr].num_outputs++;
+	}
+	for(int i = 0; rc == DLS_OK && i < c->num_nets; i++) {
+		driver[i] = -1;
+	}
+	for(int k = 0; rc == DLS_OK && k < c->num_gates; k++) {
+		int g = c->order[k];
+		for(int o = 0; o < c->gates[g].num_outputs; o++) {
+			driver[c->gates[g].outputs[o]] = g;
+		}
+	}
+	for(int gr = 0; gr < sp->num_groups && rc == DLS_OK; gr++) {
+		struct group* grp = &sp->groups[gr];
+		const uint64_t* mine = &sup[(size_t)c->outputs[first[gr]]*words];
+		for(int i = 0; i < c->num_inputs; i++) {
+			grp->num_inputs += (mine[i/64] >> (i % 64)) & 1;
+		}
+		if(grp->num_inputs > MAX_SUPPORT) {
+			rc = DLS_ERR_ARG;
+			break;
+		}
+		grp->inputs = malloc((grp->num_inputs + 1)*sizeof(int));
+		grp->outputs = malloc(grp->num_outputs*sizeof(int));
+		grp->gates = malloc((c->num_gates + 1)*sizeof(int));
+		grp->row_words = ((size_t)1 << grp->num_inputs)/64 + 1;
+		grp->table = malloc(grp->num_outputs*grp->row_words*sizeof(uint64_t));
+		if(grp->inputs == NULL || grp->outputs == NULL || grp->gates == NULL || grp->table == NULL) {
+			rc = DLS_ERR_NOMEM;
+			break;
+		}
+		int n = 0;
+		for(int i = 0; i < c->num_inputs; i++) {
+			if((mine[i/64] >> (i % 64)) & 1) {
+				grp->inputs[n++] = i;
+			}
+		}
+		/*The cone of every output of the group*/
+		memset(mark, 0, c->num_gates);
+		for(int o = 0; o < c->num_outputs; o++) {
+			if(sp->out_group[o] != gr) {
+				continue;
+			}
+			grp->outputs[sp->out_row[o]] = o;
+			int sp_top = 0;
+			if(driver[c->outputs[o]] >= 0 && !mark[driver[c->outputs[o]]]) {
+				mark[driver[c->outputs[o]]] = 1;
+				stack[sp_top++] = driver[c->outputs[o]];
+			}
+			while(sp_top > 0) {
+				const struct gate* g = &c->gates[stack[--sp_top]];
+				int fanin = gateNumFanin(g);
+				for(int f = 0; f < fanin; f++) {
+					int d = driver[gateFanin(g, f)];
+					if(d >= 0 && !mark[d]) {
+						mark[d] = 1;
+						stack[sp_top++] = d;
+					}
+				}
+			}
+		}
+		/*Back into level order*/
+		for(int k = 0; k < c->num_gates; k++) {
+			if(mark[c->order[k]]) {
+				grp->gates[grp->num_gates++] = c->order[k];
+			}
+		}
+	}
+	free(sup);
+	free(first);
+	free(driver);
+	free(mark);
+	free(stack);
+	return rc;
+}
+
+/*
+ * Function: sweepGroup
+ *
+ * Fills a group's table by evaluating its cone over every combination of its inputs
+ * Inputs outside the support stay at 0, which cannot change the outputs
+ *
+ */
+static void sweepGroup(const struct dls_circuit* c, struct group* grp, struct dls_state* s) {
+	/*Bit k of lanePattern[b] is bit b of k*/
+	static const uint64_t lanePattern[6] = {
+		0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+		0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+	};
+	uint64_t* v = s->nets;
+	int n = grp->num_inputs;
+	uint64_t combos = (uint64_t)1 << n;
+	for(uint64_t base = 0; base < combos; base += 64) {
+		for(int i = 0; i < n; i++) {
+			int b = n - 1 - i;
+			v[c->inputs[grp->inputs[i]]] = (b < 6) ? lanePattern[b] : ((base >> b) & 1) ? ~(uint64_t)0 : 0;
+		}
+		for(int k = 0; k < grp->num_gates; k++) {
+			const struct gate* g = &c->gates[grp->gates[k]];
+			if(g->oper == OP_INSTANCE) {
+				evalInstance(g, v, s->subs);
+			}
+			else {
+				evalGate(g, v, s->scratch);
+			}
+		}
+		for(int j = 0; j < grp->num_outputs; j++) {
+			grp->table[j*grp->row_words + base/64] = v[c->outputs[grp->outputs[j]]];
+		}
+	}
+	for(int i = 0; i < n; i++) {
+		v[c->inputs[grp->inputs[i]]] = 0;
+	}
+}
+
+/*
+ * Function: dlsSupportNew
+ *
+ * Groups the outputs of a compiled circuit by structural support and sweeps
+ * each group over its own inputs
+ * Flip-flops are held at 0
+ *
+ * rc: Set to DLS_OK, DLS_ERR_STATE if the circuit is not compiled, DLS_ERR_ARG if
+ *	an output depends on more than 40 inputs, or DLS_ERR_NOMEM
+ *
+ * returns: The groups and their tables, or NULL on error
+ */
+struct dls_support* dlsSupportNew(const struct dls_circuit* c, int* rc) {
+	if(c == NULL || !c->compiled) {
+		*rc = DLS_ERR_STATE;
+		return NULL;
+	}
+	struct dls_support* sp = calloc(1, sizeof(struct dls_support));
+	struct dls_state* s = dlsStateNew(c);
+	if(sp == NULL || s == NULL) {
+		free(sp);
+		dlsStateFree(s);
+		*rc = DLS_ERR_NOMEM;
+		return NULL;
+	}
+	sp->circuit = c;
+	sp->out_group = malloc((c->num_outputs + 1)*sizeof(int));
+	sp->out_row = malloc((c->num_outputs + 1)*sizeof(int));
+	*rc = (sp->out_group == NULL || sp->out_row == NULL) ? DLS_ERR_NOMEM : buildGroups(sp);
+	for(int gr = 0; gr < sp->num_groups && *rc == DLS_OK; gr++) {
+		sweepGroup(c, &sp->groups[gr], s);
+	}
+	dlsStateFree(s);
+	if(*rc != DLS_OK) {
+		dlsSupportFree(sp);
+		return NULL;
+	}
+	return sp;
+}
+
+void dlsSupportFree(struct dls_support* sp) {
+	if(sp == NULL) {
+		return;
+	}
+	for(int gr = 0; sp->groups != NULL && gr < sp->num_groups; gr++) {
+		free(sp->groups[gr].inputs);
+		free(sp->groups[gr].outputs);
+		free(sp->groups[gr].gates);
+		free(sp->groups[gr].table);
+	}
+	free(sp->groups);
+	free(sp->out_group);
+	free(sp->out_row);
+	free(sp);
+}
+
+/*
+ * Functions: Support groups
+ *
+ * The groups, numbered from 0, their support inputs and outputs as INPUTVAR and
+ * OUTPUTVAR indices, and the number of combinations swept for all of them
+ */
+
+int dlsSupportNumGroups(const struct dls_support* sp) {
+	return sp->num_groups;
+}
+
+int dlsSupportGroupInputs(const struct dls_support* sp, int gr, const int** inputs) {
+	*inputs = sp->groups[gr].inputs;
+	return sp->groups[gr].num_inputs;
+}
+
+int dlsSupportGroupOutputs(const struct dls_support* sp, int gr, const int** outputs) {
+	*outputs = sp->groups[gr].outputs;
+	return sp->groups[gr].num_outputs;
+}
+
+uint64_t dlsSupportSwept(const struct dls_support* sp) {
+	uint64_t total = 0;
+	for(int gr = 0; gr < sp->num_groups; gr++) {
+		total += (uint64_t)1 << sp->groups[gr].num_inputs;
+	}
+	return total;
+}
+
+/*
+ * Function: dlsSupportLookup
+ *
+ * returns: The value of an output when the inputs of its group spell index,
+ *	the first support input being the most significant bit
+ */
+int dlsSupportLookup(const struct dls_support* sp, int output, uint64_t index) {
+	const struct group* grp = &sp->groups[sp->out_group[output]];
+	return (grp->table[sp->out_row[output]*grp->row_words + index/64] >> (index % 64)) & 1;
+}
+
+/*
+ * Function: dlsSupportEval
+ *
+ * Sets the output words of a state from the group tables, for the input words
+ * already set in it, as dlsEvalWords would but without evaluating any gate
+ * Internal nets are left as they were
+ *
+ */
+void dlsSupportEval(const struct dls_support* sp, struct dls_state* s) {
+	const struct dls_circuit* c = sp->circuit;
+	uint64_t* v = s->nets;
+	for(int gr = 0; gr < sp->num_groups; gr++) {
+		const struct group* grp = &sp->groups[gr];
+		uint64_t index[64] = {0};
+		for(int i = 0; i < grp->num_inputs; i++) {
+			uint64_t w = v[c->inputs[grp->inputs[i]]];
+			for(int k = 0; k < 64; k++) {
+				index[k] = (index[k] << 1) | ((w >> k) & 1);
+			}
+		}
+		for(int j = 0; j < grp->num_outputs; j++) {
+			const uint64_t* row = &grp->table[j*grp->row_words];
+			uint64_t word = 0;
+			for(int k = 0; k < 64; k++) {
+				word |= ((row[index[k]/64] >> (index[k] % 64)) & 1) << k;
+			}
+			v[c->outputs[grp->outputs[j]]] = word;
+		}
+	}
+}
@@ -0,0 +1,484 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Three-valued simulation
+ *
+ * Each net is two words, hi and lo: bit k of hi is set when the net can be 1 in
+ * vector k, and bit k of lo when it can be 0. A known 1 is hi only, a known 0 is lo
+ * only, and X sets both. Every gate follows Kleene's logic, so an output is only X
+ * when the known inputs do not decide it, and 64 vectors are still evaluated in
+ * one pass over the gates.
+ */
+
+/*
+ * Structure: touched
+ *
+ * Outputs of one wide decoder that are not 0 in every lane
+ *
+ * list: Output indices, in the order they were set
+ *
+ * all: True if the list could not grow, so that every output must be cleared
+ *
+ */
+struct touched {
+	int* list;
+	int count;
+	int cap;
+	bool all;
+};
+
+/*
+ * Structure: dls_xstate
+ *
+ * Per-thread three-valued state
+ *
+ * hi, lo: The two words of every net, indexed like the nets of a dls_state
+ *
+ * scratch: Two halves of scratch_words words, for the hi and lo minterms
+ *
+ * latch_hi, latch_lo: One word per flip-flop, the next state while clocking
+ *
+ * wide: One entry per decoder wider than SPARSE_SELECTS, in order of their hot slots
+ *
+ * subs: One state per module template, shared by its instances as in dls_state
+ *
+ */
+struct dls_xstate {
+	const struct dls_circuit* circuit;
+	uint64_t* hi;
+	uint64_t* lo;
+	uint64_t* scratch;
+	uint64_t* latch_hi;
+	uint64_t* latch_lo;
+	struct touched* wide;
+	int num_wide;
+	struct dls_xstate** subs;
+	int num_subs;
+};
+
+static void evalXNets(const struct dls_circuit*, struct dls_xstate*, struct dls_xstate**);
+
+/*
+ * Function: dlsXStateNew
+ *
+ * Allocates a three-valued state for a compiled circuit
+ * Every net, flip-flops included, starts at X
+ *
+ * returns: The state, or NULL if out of memory or the circuit is not compiled
+ */
+struct dls_xstate* dlsXStateNew(const struct dls_circuit* c) {
+	if(c == NULL || !c->compiled) {
+		return NULL;
+	}
+	struct dls_xstate* s = calloc(1, sizeof(struct dls_xstate));
+	if(s == NULL) {
+		return NULL;
+	}
+	s->circuit = c;
+	s->hi = malloc(c->num_words*sizeof(uint64_t));
+	s->lo = malloc(c->num_words*sizeof(uint64_t));
+	s->scratch = malloc(2*c->scratch_words*sizeof(uint64_t));
+	s->latch_hi = malloc((c->num_regs + 1)*sizeof(uint64_t));
+	s->latch_lo = malloc((c->num_regs + 1)*sizeof(uint64_t));
+	s->num_wide = (c->num_words - c->num_nets)/64;
+	s->wide = calloc(s->num_wide + 1, sizeof(struct touched));
+	s->num_subs = c->num_modules;
+	s->subs = calloc(c->num_modules + 1, sizeof(struct dls_xstate*));
+	if(s->hi == NULL || s->lo == NULL || s->scratch == NULL || s->latch_hi == NULL || s->latch_lo == NULL || s->wide == NULL || s->subs == NULL) {
+		dlsXStateFree(s);
+		return NULL;
+	}
+	for(int i = 0; i < c->num_modules; i++) {
+		s->subs[i] = dlsXStateNew(c->modules[i]);
+		if(s->subs[i] == NULL) {
+			dlsXStateFree(s);
+			return NULL;
+		}
+	}
+	memset(s->hi, 0xff, c->num_words*sizeof(uint64_t));
+	memset(s->lo, 0xff, c->num_words*sizeof(uint64_t));
+	s->lo[NET_ONE] = 0;
+	s->hi[NET_ZERO] = 0;
+	/*Wide decoders only clear the outputs they set, so theirs start at 0*/
+	for(int k = 0; k < c->num_gates; k++) {
+		const struct gate* g = &c->gates[k];
+		for(int o = 0; g->hot >= 0 && o < g->num_outputs; o++) {
+			s->hi[g->outputs[o]] = 0;
+		}
+	}
+	return s;
+}
+
+void dlsXStateFree(struct dls_xstate* s) {
+	if(s == NULL) {
+		return;
+	}
+	free(s->hi);
+	free(s->lo);
+	free(s->scratch);
+	free(s->latch_hi);
+	free(s->latch_lo);
+	for(int i = 0; s->wide != NULL && i < s->num_wide; i++) {
+		free(s->wide[i].list);
+	}
+	free(s->wide);
+	if(s->subs != NULL) {
+		for(int i = 0; i < s->num_subs; i++) {
+			dlsXStateFree(s->subs[i]);
+		}
+	}
+	free(s->subs);
+	free(s);
+}
+
+/*
+ * Functions: Three-valued state access
+ *
+ * Words are passed as a value and an unknown mask: bit k of unknown set means
+ * vector k is X, otherwise bit k of value is its value
+ */
+
+void dlsXSetInput(struct dls_xstate* s, int i, uint64_t value, uint64_t unknown) {
+	int slot = s->circuit->inputs[i];
+	s->hi[slot] = value | unknown;
+	s->lo[slot] = ~value | unknown;
+}
+
+void dlsXGetOutput(const struct dls_xstate* s, int i, uint64_t* value, uint64_t* unknown) {
+	int slot = s->circuit->outputs[i];
+	*unknown = s->hi[slot] & s->lo[slot];
+	*value = s->hi[slot] & ~s->lo[slot];
+}
+
+void dlsXGetNet(const struct dls_xstate* s, int net, uint64_t* value, uint64_t* unknown) {
+	int slot = s->circuit->net_slot[net];
+	*unknown = s->hi[slot] & s->lo[slot];
+	*value = s->hi[slot] & ~s->lo[slot];
+}
+
+/*
+ * Function: dlsXResetRegisters
+ *
+ * Sets every flip-flop of a state to a known 0 in all 64 streams
+ *
+ */
+void dlsXResetRegisters(struct dls_xstate* s) {
+	const struct dls_circuit* c = s->circuit;
+	for(int r = 0; r < c->num_regs; r++) {
+		s->hi[c->regs[r].q] = 0;
+		s->lo[c->regs[r].q] = ~(uint64_t)0;
+	}
+}
+
+/*
+ * Function: dlsXClock
+ *
+ * Latches all flip-flops, as dlsClock does
+ * A reset that is X leaves the flip-flop X unless its data input is 0
+ *
+ */
+void dlsXClock(const struct dls_circuit* c, struct dls_xstate* s) {
+	const struct reg* regs = c->regs;
+	for(int r = 0; r < c->num_regs; r++) {
+		uint64_t hi = s->hi[regs[r].d];
+		uint64_t lo = s->lo[regs[r].d];
+		if(regs[r].rst != -1) {
+			hi &= s->lo[regs[r].rst];
+			lo |= s->hi[regs[r].rst];
+		}
+		s->latch_hi[r] = hi;
+		s->latch_lo[r] = lo;
+	}
+	for(int r = 0; r < c->num_regs; r++) {
+		s->hi[regs[r].q] = s->latch_hi[r];
+		s->lo[regs[r].q] = s->latch_lo[r];
+	}
+}
+
+/*
+ * Function: evalXDecoder
+ *
+ * Each minterm is the AND of one literal per select: it can be 1 when every
+ * literal can be 1, and can be 0 when any literal can be 0
+ *
+ */
+static void evalXDecoder(const struct gate* g, uint64_t* hi, uint64_t* lo, uint64_t* mh, uint64_t* ml) {
+	int n = g->num_inputs;
+	mh[0] = ~(uint64_t)0;
+	ml[0] = 0;
+	for(int i = 0; i < n; i++) {
+		uint64_t sh = hi[g->inputs[i]];
+		uint64_t sl = lo[g->inputs[i]];
+		for(int code = (1 << i) - 1; code >= 0; code--) {
+			uint64_t th = mh[code];
+			uint64_t tl = ml[code];
+			mh[2*code + 1] = th & sh;
+			ml[2*code + 1] = tl | sl;
+			mh[2*code] = th & sl;
+			ml[2*code] = tl | sh;
+		}
+	}
+	for(int l = 0; l < (1 << n); l++) {
+		hi[g->outputs[l]] = mh[l ^ (l >> 1)];
+		lo[g->outputs[l]] = ml[l ^ (l >> 1)];
+	}
+}
+
+/*
+ * Function: evalXWideDecoder
+ *
+ * Decoder with more than SPARSE_SELECTS selects
+ * A lane with t X selects can raise any of the 2^t outputs its known selects allow,
+ * each of them to X; the others stay 0. Only outputs set last time are cleared
+ *
+ */
+static void evalXWideDecoder(const struct gate* g, uint64_t* hi, uint64_t* lo, struct touched* t) {
+	if(t->all) {
+		for(int l = 0; l < g->num_outputs; l++) {
+			hi[g->outputs[l]] = 0;
+			lo[g->outputs[l]] = ~(uint64_t)0;
+		}
+		t->all = false;
+	}
+	for(int k = 0; k < t->count; k++) {
+		hi[g->outputs[t->list[k]]] = 0;
+		lo[g->outputs[t->list[k]]] = ~(uint64_t)0;
+	}
+	t->count = 0;
+	uint64_t code[64] = {0};
+	uint64_t unknown[64] = {0};
+	for(int i = 0; i < g->num_inputs; i++) {
+		uint64_t sh = hi[g->inputs[i]];
+		uint64_t sl = lo[g->inputs[i]];
+		for(int k = 0; k < 64; k++) {
+			code[k] = (code[k] << 1) | ((sh >> k) & 1);
+			unknown[k] = (unknown[k] << 1) | ((sh >> k) & (sl >> k) & 1);
+		}
+	}
+	for(int k = 0; k < 64; k++) {
+		uint64_t bit = (uint64_t)1 << k;
+		uint64_t fixed = code[k] & ~unknown[k];
+		uint64_t sub = 0;
+		do { //Every assignment of the X selects
+			int l = (int)grayToBinary64(fixed | sub);
+			int out = g->outputs[l];
+			if(hi[out] == 0 && !t->all) {
+				if(t->count == t->cap) {
+					int cap = (t->cap == 0) ? 64 : 2*t->cap;
+					int* grown = realloc(t->list, cap*sizeof(int));
+					if(grown == NULL) {
+						t->all = true;
+					}
+					else {
+						t->list = grown;
+						t->cap = cap;
+					}
+				}
+				if(!t->all) {
+					t->list[t->count++] = l;
+				}
+			}
+			hi[out] |= bit;
+			if(unknown[k] == 0) {
+				lo[out] &= ~bit;
+			}
+			sub = (sub - unknown[k]) & unknown[k];
+		} while(sub != 0);
+	}
+}
+
+/*
+ * Function: evalXMultiplexer
+ *
+ * Reduces the encodings pairwise as evalMultiplexer does; where a select is X both
+ * halves are merged, so the output is X only if the encodings it can pick disagree
+ *
+ */
+static void evalXMultiplexer(const struct gate* g, uint64_t* hi, uint64_t* lo, uint64_t* mh, uint64_t* ml) {
+	int n = g->num_inputs;
+	int size = 1 << n;
+	for(int code = 0; code < size; code++) {
+		int net = g->multi[grayToBinary64(code)];
+		mh[code] = hi[net];
+		ml[code] = lo[net];
+	}
+	for(int i = n - 1; i >= 0; i--) {
+		uint64_t sh = hi[g->inputs[i]];
+		uint64_t sl = lo[g->inputs[i]];
+		size >>= 1;
+		for(int code = 0; code < size; code++) {
+			mh[code] = (mh[2*code] & sl) | (mh[2*code + 1] & sh);
+			ml[code] = (ml[2*code] & sl) | (ml[2*code + 1] & sh);
+		}
+	}
+	hi[g->outputs[0]] = mh[0];
+	lo[g->outputs[0]] = ml[0];
+}
+
+/*
+ * Function: evalXGate
+ *
+ * Evaluates one gate on 64 three-valued vectors
+ * AND can be 1 when all inputs can be 1 and can be 0 when any can be 0, OR is its
+ * dual, and XOR can be 1 or 0 whenever an input is X
+ *
+ */
+static void evalXGate(const struct gate* g, struct dls_xstate* s) {
+	uint64_t* hi = s->hi;
+	uint64_t* lo = s->lo;
+	const int* in = g->inputs;
+	int out = g->outputs[0];
+	uint64_t h;
+	uint64_t l;
+	switch(g->oper) {
+		case OP_NOT:
+			h = lo[in[0]];
+			lo[out] = hi[in[0]];
+			hi[out] = h;
+			return;
+		case OP_AND:
+		case OP_NAND:
+			h = hi[in[0]];
+			l = lo[in[0]];
+			for(int k = 1; k < g->num_inputs; k++) {
+				h &= hi[in[k]];
+				l |= lo[in[k]];
+			}
+			break;
+		case OP_OR:
+		case OP_NOR:
+			h = hi[in[0]];
+			l = lo[in[0]];
+			for(int k = 1; k < g->num_inputs; k++) {
+				h |= hi[in[k]];
+				l &= lo[in[k]];
+			}
+			break;
+		case OP_XOR:
+		case OP_XNOR:
+			h = hi[in[0]];
+			l = lo[in[0]];
+			for(int k = 1; k < g->num_inputs; k++) {
+				uint64_t bh = hi[in[k]];
+				uint64_t bl = lo[in[k]];
+				uint64_t th = (h & bl) | (l & bh);
+				l = (h & bh) | (l & bl);
+				h = th;
+			}
+			break;
+		case OP_DECODER:
+			if(g->hot >= 0) {
+				evalXWideDecoder(g, hi, lo, &s->wide[(g->hot - s->circuit->num_nets)/64]);
+			}
+			else {
+				evalXDecoder(g, hi, lo, s->scratch, s->scratch + s->circuit->scratch_words);
+			}
+			return;
+		case OP_MULTIPLEXER:
+			evalXMultiplexer(g, hi, lo, s->scratch, s->scratch + s->circuit->scratch_words);
+			return;
+		default:
+			return;
+	}
+	if(g->oper == OP_NAND || g->oper == OP_NOR || g->oper == OP_XNOR) {
+		hi[out] = l;
+		lo[out] = h;
+	}
+	else {
+		hi[out] = h;
+		lo[out] = l;
+	}
+}
+
+/*
+ * Function: evalXInstance
+ *
+ * Evaluates one instance through its template's shared state, as evalInstance does
+ *
+ */
+static void evalXInstance(const struct gate* g, struct dls_xstate* s, struct dls_xstate** subs) {
+	const struct dls_circuit* m = g->sub;
+	struct dls_xstate* sub = subs[m->module_index];
+	for(int i = 0; i < m->num_inputs; i++) {
+		sub->hi[m->inputs[i]] = s->hi[g->inputs[i]];
+		sub->lo[m->inputs[i]] = s->lo[g->inputs[i]];
+	}
+	evalXNets(m, sub, subs);
+	for(int o = 0; o < m->num_outputs; o++) {
+		s->hi[g->outputs[o]] = sub->hi[m->outputs[o]];
+		s->lo[g->outputs[o]] = sub->lo[m->outputs[o]];
+	}
+}
+
+static void evalXNets(const struct dls_circuit* c, struct dls_xstate* s, struct dls_xstate** subs) {
+	for(int k = 0; k < c->num_gates; k++) {
+		const struct gate* g = &c->gates[c->order[k]];
+		if(g->oper == OP_INSTANCE) {
+			evalXInstance(g, s, subs);
+		}
+		else {
+			evalXGate(g, s);
+		}
+	}
+}
+
+/*
+ * Function: dlsXEvalWords
+ *
+ * Evaluates 64 three-valued vectors at once
+ * The input words must have been set with dlsXSetInput
+ *
+ */
+void dlsXEvalWords(const struct dls_circuit* c, struct dls_xstate* s) {
+	evalXNets(c, s, s->subs);
+}
+
+/*
+ * Function: dlsXEval
+ *
+ * Evaluates a batch of three-valued vectors into a caller provided buffer,
+ * flip-flops held at X
+ *
+ * in: count rows of dlsNumInputs bytes, each 0, 1 or DLS_X, in INPUTVAR order
+ *
+ * out: count rows of dlsNumOutputs bytes, filled with 0, 1 or DLS_X
+ *
+ * returns: DLS_OK, DLS_ERR_STATE if c is not compiled, or DLS_ERR_NOMEM
+ */
+int dlsXEval(const struct dls_circuit* c, const unsigned char* in, unsigned char* out, size_t count) {
+	if(c == NULL || !c->compiled) {
+		return DLS_ERR_STATE;
+	}
+	struct dls_xstate* s = dlsXStateNew(c);
+	if(s == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	int ni = c->num_inputs;
+	int no = c->num_outputs;
+	for(size_t base = 0; base < count; base += 64) {
+		int lanes = (count - base < 64) ? (int)(count - base) : 64;
+		for(int i = 0; i < ni; i++) {
+			uint64_t value = 0;
+			uint64_t unknown = 0;
+			for(int k = 0; k < lanes; k++) {
+				unsigned char b = in[(base + k)*ni + i];
+				value |= (uint64_t)(b == 1) << k;
+				unknown |= (uint64_t)(b == DLS_X) << k;
+			}
+			dlsXSetInput(s, i, value, unknown);
+		}
+		dlsXEvalWords(c, s);
+		for(int o = 0; o < no; o++) {
+			uint64_t value;
+			uint64_t unknown;
+			dlsXGetOutput(s, o, &value, &unknown);
+			for(int k = 0; k < lanes; k++) {
+				out[(base + k)*no + o] = ((unknown >> k) & 1) ? DLS_X : (value >> k) & 1;
+			}
+		}
+	}
+	dlsXStateFree(s);
+	return DLS_OK;
+}
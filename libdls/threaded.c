@@ -0,0 +1,396 @@
+#include<stdlib.h>
+#include "dls_internal.h"
+
+/*
+ * Direct-threaded evaluation
+ *
+ * evalGate switches on the opcode of every gate and loops over its fanin. A program
+ * translates the levelized gates once into a flat list of instructions, each holding
+ * the address of its handler, and every handler jumps straight to the next one's, so
+ * each gate costs one indirect jump that the branch predictor sees per call site.
+ * Handlers are specialized by opcode and arity: two input gates, multiplexers with one
+ * or two selects and decoders with up to three selects have their own, anything else
+ * falls back to evalGate. Common pairs are fused into one instruction when the first
+ * gate's output feeds nothing but the second: NOT into AND or OR, and AND into OR.
+ * The fused handler still writes the inner net, so every net keeps its value.
+ */
+
+/*Instructions*/
+#define INSN_NOT 0
+#define INSN_AND2 1
+#define INSN_OR2 2
+#define INSN_NAND2 3
+#define INSN_NOR2 4
+#define INSN_XOR2 5
+#define INSN_XNOR2 6
+#define INSN_ANDNOT 7 //a = NOT b, out = a AND c
+#define INSN_ORNOT 8 //a = NOT b, out = a OR c
+#define INSN_ANDOR 9 //a = b AND d, out = a OR c
+#define INSN_MUX1 10
+#define INSN_MUX2 11
+#define INSN_DEC1 12
+#define INSN_DEC2 13
+#define INSN_DEC3 14
+#define INSN_GATE 15 //Any other gate, through evalGate
+#define INSN_INSTANCE 16
+#define INSN_END 17
+
+/*
+ * Structure: insn
+ *
+ * One instruction
+ *
+ * handler: Address of the handler, filled in by linking the program
+ *
+ * a, b, c, d, out: Slots of the operands, as listed next to the instruction numbers
+ *	For the two input gates, out = b op c
+ *
+ */
+struct insn {
+	const void* handler;
+	const struct gate* gate;
+	int op;
+	int a;
+	int b;
+	int c;
+	int d;
+	int out;
+};
+
+/*
+ * Structure: dls_program
+ *
+ * The threaded code of one compiled circuit
+ *
+ */
+struct dls_program {
+	const struct dls_circuit* circuit;
+	struct insn* insns;
+	int num_insns;
+	int num_fused;
+};
+
+/*
+ * Function: runProgram
+ *
+ * Runs the instructions of a program on one word, or links them
+ *
+ * link: If true, only stores the handler address of every instruction
+ *
+ */
+static void runProgram(struct dls_program* p, uint64_t* v, uint64_t* scratch, struct dls_state** subs, bool link) {
+	static const void* const handlers[] = {
+		&&not, &&and2, &&or2, &&nand2, &&nor2, &&xor2, &&xnor2, &&andnot, &&ornot, &&andor,
+		&&mux1, &&mux2, &&dec1, &&dec2, &&dec3, &&gate, &&instance, &&end
+	};
+	if(link) {
+		for(int k = 0; k < p->num_insns; k++) {
+			p->insns[k].handler = handlers[p->insns[k].op];
+		}
+		return;
+	}
+	const struct insn* ip = p->insns;
+	uint64_t t, s, lo, hi;
+	goto *ip->handler;
+not:
+	v[ip->out] = ~v[ip->b];
+	ip++;
+	goto *ip->handler;
+and2:
+	v[ip->out] = v[ip->b] & v[ip->c];
+	ip++;
+	goto *ip->handler;
+or2:
+	v[ip->out] = v[ip->b] | v[ip->c];
+	ip++;
+	goto *ip->handler;
+nand2:
+	v[ip->out] = ~(v[ip->b] & v[ip->c]);
+	ip++;
+	goto *ip->handler;
+nor2:
+	v[ip->out] = ~(v[ip->b] | v[ip->c]);
+	ip++;
+	goto *ip->handler;
+xor2:
+	v[ip->out] = v[ip->b] ^ v[ip->c];
+	ip++;
+	goto *ip->handler;
+xnor2:
+	v[ip->out] = ~(v[ip->b] ^ v[ip->c]);
+	ip++;
+	goto *ip->handler;
+andnot:
+	t = ~v[ip->b];
+	v[ip->a] = t;
+	v[ip->out] = t & v[ip->c];
+	ip++;
+	goto *ip->handler;
+ornot:
+	t = ~v[ip->b];
+	v[ip->a] = t;
+	v[ip->out] = t | v[ip->c];
+	ip++;
+	goto *ip->handler;
+andor:
+	t = v[ip->b] & v[ip->d];
+	v[ip->a] = t;
+	v[ip->out] = t | v[ip->c];
+	ip++;
+	goto *ip->handler;
+mux1:
+	s = v[ip->gate->inputs[0]];
+	v[ip->out] = (v[ip->gate->multi[0]] & ~s) | (v[ip->gate->multi[1]] & s);
+	ip++;
+	goto *ip->handler;
+mux2: {
+	const int* e = ip->gate->multi;
+	uint64_t high = v[ip->gate->inputs[0]]; //Gray code to binary: the high bit stays,
+	s = high ^ v[ip->gate->inputs[1]]; //the low bit is the XOR of both selects
+	lo = (v[e[0]] & ~s) | (v[e[1]] & s);
+	hi = (v[e[2]] & ~s) | (v[e[3]] & s);
+	v[ip->out] = (lo & ~high) | (hi & high);
+	ip++;
+	goto *ip->handler;
+}
+dec1:
+	s = v[ip->gate->inputs[0]];
+	v[ip->gate->outputs[0]] = ~s;
+	v[ip->gate->outputs[1]] = s;
+	ip++;
+	goto *ip->handler;
+dec2: {
+	const int* o = ip->gate->outputs;
+	hi = v[ip->gate->inputs[0]];
+	lo = v[ip->gate->inputs[1]];
+	v[o[0]] = ~hi & ~lo;
+	v[o[1]] = ~hi & lo;
+	v[o[2]] = hi & lo;
+	v[o[3]] = hi & ~lo;
+	ip++;
+	goto *ip->handler;
+}
+dec3: {
+	const int* o = ip->gate->outputs;
+	hi = v[ip->gate->inputs[0]];
+	t = v[ip->gate->inputs[1]];
+	lo = v[ip->gate->inputs[2]];
+	uint64_t p0 = ~hi & ~t;
+	uint64_t p1 = ~hi & t;
+	uint64_t p2 = hi & ~t;
+	uint64_t p3 = hi & t;
+	v[o[0]] = p0 & ~lo; //Output l fires for the select code l^(l>>1)
+	v[o[1]] = p0 & lo;
+	v[o[2]] = p1 & lo;
+	v[o[3]] = p1 & ~lo;
+	v[o[4]] = p3 & ~lo;
+	v[o[5]] = p3 & lo;
+	v[o[6]] = p2 & lo;
+	v[o[7]] = p2 & ~lo;
+	ip++;
+	goto *ip->handler;
+}
+gate:
+	evalGate(ip->gate, v, scratch);
+	ip++;
+	goto *ip->handler;
+instance:
+	evalInstance(ip->gate, v, subs);
+	ip++;
+	goto *ip->handler;
+end:
+	return;
+}
+
+/*
+ * Function: isTwoInput
+ *
+ * returns: True if the gate is an AND or OR with exactly two inputs
+ */
+static bool isTwoInput(const struct gate* g, int oper) {
+	return g->oper == oper && g->num_inputs == 2;
+}
+
+/*
+ * Function: findFusions
+ *
+ * Picks the gates to fuse into the gate reading their output
+ * A gate takes part in at most one fusion, either as the inner or the outer gate
+ *
+ * into: Per gate, the gate it is fused into, or -1
+ *
+ * inner: Per gate, the gate fused into it, or -1
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int findFusions(const struct dls_circuit* c, int* into, int* inner) {
+	int* fanout = calloc(c->num_nets, sizeof(int));
+	int* driver = malloc(c->num_nets*sizeof(int));
+	if(fanout == NULL || driver == NULL) {
+		free(fanout);
+		free(driver);
+		return DLS_ERR_NOMEM;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		driver[i] = -1;
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		const struct gate* gt = &c->gates[g];
+		into[g] = -1;
+		inner[g] = -1;
+		for(int k = 0; k < gateNumFanin(gt); k++) {
+			fanout[gateFanin(gt, k)]++;
+		}
+		for(int o = 0; o < gt->num_outputs; o++) {
+			driver[gt->outputs[o]] = g;
+		}
+	}
+	for(int g = 0; g < c->num_gates; g++) {
+		const struct gate* gt = &c->gates[g];
+		if((!isTwoInput(gt, OP_AND) && !isTwoInput(gt, OP_OR)) || into[g] != -1) {
+			continue;
+		}
+		for(int k = 0; k < 2; k++) {
+			int net = gt->inputs[k];
+			int d = driver[net];
+			if(d < 0 || fanout[net] != 1 || into[d] != -1 || inner[d] != -1) {
+				continue;
+			}
+			const struct gate* dt = &c->gates[d];
+			if(dt->oper == OP_NOT || (gt->oper == OP_OR && isTwoInput(dt, OP_AND))) {
+				into[d] = g;
+				inner[g] = d;
+				break;
+			}
+		}
+	}
+	free(fanout);
+	free(driver);
+	return DLS_OK;
+}
+
+/*
+ * Function: emitGate
+ *
+ * Translates one gate, and the gate fused into it if any, into an instruction
+ *
+ * inner: The gate fused into g, or NULL
+ *
+ */
+static void emitGate(struct insn* in, const struct gate* g, const struct gate* inner) {
+	static const int twoInput[] = {-1, INSN_AND2, INSN_OR2, INSN_NAND2, INSN_NOR2, INSN_XOR2, INSN_XNOR2};
+	in->gate = g;
+	in->out = (g->num_outputs > 0) ? g->outputs[0] : NET_ZERO;
+	in->op = INSN_GATE;
+	if(g->oper == OP_INSTANCE) {
+		in->op = INSN_INSTANCE;
+	}
+	else if(inner != NULL) {
+		int other = (g->inputs[0] == inner->outputs[0]) ? g->inputs[1] : g->inputs[0];
+		in->a = inner->outputs[0];
+		in->b = inner->inputs[0];
+		in->c = other;
+		if(inner->oper == OP_NOT) {
+			in->op = (g->oper == OP_AND) ? INSN_ANDNOT : INSN_ORNOT;
+		}
+		else {
+			in->op = INSN_ANDOR;
+			in->d = inner->inputs[1];
+		}
+	}
+	else if(g->oper == OP_NOT) {
+		in->op = INSN_NOT;
+		in->b = g->inputs[0];
+	}
+	else if(g->oper <= OP_XNOR && g->num_inputs == 2) {
+		in->op = twoInput[g->oper];
+		in->b = g->inputs[0];
+		in->c = g->inputs[1];
+	}
+	else if(g->oper == OP_MULTIPLEXER && g->num_inputs <= 2) {
+		in->op = (g->num_inputs == 1) ? INSN_MUX1 : INSN_MUX2;
+	}
+	else if(g->oper == OP_DECODER && g->num_inputs >= 1 && g->num_inputs <= 3) {
+		in->op = INSN_DEC1 + g->num_inputs - 1;
+	}
+}
+
+/*
+ * Function: dlsProgramNew
+ *
+ * Translates a compiled circuit into threaded code
+ *
+ * returns: The program, or NULL if the circuit is not compiled or out of memory
+ */
+struct dls_program* dlsProgramNew(const struct dls_circuit* c) {
+	if(c == NULL || !c->compiled) {
+		return NULL;
+	}
+	struct dls_program* p = calloc(1, sizeof(struct dls_program));
+	int* into = malloc((c->num_gates + 1)*sizeof(int));
+	int* inner = malloc((c->num_gates + 1)*sizeof(int));
+	if(p != NULL) {
+		p->circuit = c;
+		p->insns = calloc(c->num_gates + 1, sizeof(struct insn));
+	}
+	if(p == NULL || p->insns == NULL || into == NULL || inner == NULL || findFusions(c, into, inner) != DLS_OK) {
+		dlsProgramFree(p);
+		free(into);
+		free(inner);
+		return NULL;
+	}
+	for(int k = 0; k < c->num_gates; k++) {
+		int g = c->order[k];
+		if(into[g] != -1) {
+			p->num_fused++;
+			continue; //Runs as part of the gate it feeds
+		}
+		emitGate(&p->insns[p->num_insns++], &c->gates[g], inner[g] != -1 ? &c->gates[inner[g]] : NULL);
+	}
+	p->insns[p->num_insns++].op = INSN_END;
+	runProgram(p, NULL, NULL, NULL, true);
+	free(into);
+	free(inner);
+	return p;
+}
+
+void dlsProgramFree(struct dls_program* p) {
+	if(p == NULL) {
+		return;
+	}
+	free(p->insns);
+	free(p);
+}
+
+/*
+ * Function: dlsProgramNumInsns
+ *
+ * returns: The number of instructions run per word, not counting the final one
+ */
+int dlsProgramNumInsns(const struct dls_program* p) {
+	return p->num_insns - 1;
+}
+
+/*
+ * Function: dlsProgramNumFused
+ *
+ * returns: The number of gates fused into the gate they feed
+ */
+int dlsProgramNumFused(const struct dls_program* p) {
+	return p->num_fused;
+}
+
+/*
+ * Function: dlsProgramEval
+ *
+ * Same as dlsEvalWords, through the threaded code
+ * A program may be run from several threads, each with its own state
+ *
+ * p: A program created for the state's circuit
+ *
+ * s: The state, inputs already set
+ *
+ */
+void dlsProgramEval(const struct dls_program* p, struct dls_state* s) {
+	runProgram((struct dls_program*)p, s->nets, s->scratch, s->subs, false);
+}
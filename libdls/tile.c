@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include<stdlib.h>
+#include<unistd.h>
+#include "dls_internal.h"
+
+/*
+ * Cache-blocked evaluation
+ *
+ * Evaluating the whole circuit for one word at a time streams every net word and
+ * gate record through the cache once per word. A tiling cuts the gates, already in
+ * level order, into tiles small enough for their gates, pins and net words to stay
+ * in L2, and runs each tile over a block of words before moving to the next tile.
+ * Nets crossing from one tile to a later one, and the primary inputs and outputs,
+ * are spilled to a compact buffer holding one row of block words per net; everything
+ * else only ever lives in the tiling's own state.
+ */
+
+/*Bytes touched per gate: the record, about three pins and one net word*/
+#define BYTES_PER_GATE (sizeof(struct gate) + 3*sizeof(int) + sizeof(uint64_t))
+
+/*L2 size assumed when the system does not report it*/
+#define DEFAULT_L2 (1024*1024)
+
+/*Bounds of the auto-tuned sizes*/
+#define MIN_TILE_GATES 64
+#define MIN_BLOCK_WORDS 8
+#define MAX_BLOCK_WORDS 256
+
+/*
+ * Structure: tile
+ *
+ * A run of gates in level order
+ *
+ * first, last: order[first] to order[last-1] are the gates of the tile
+ *
+ * reads: Slots the tile reads from the spill buffer before each word
+ *
+ * writes: Slots the tile writes to the spill buffer after each word
+ *
+ */
+struct tile {
+	int first;
+	int last;
+	int* reads;
+	int num_reads;
+	int* writes;
+	int num_writes;
+};
+
+/*
+ * Structure: dls_tiling
+ *
+ * A tiling of one compiled circuit, with the state and spill buffer to run it
+ *
+ * spill_row: Slot to row of the spill buffer, -1 for nets that are not spilled
+ *
+ * spill: num_spill rows of block_words words
+ *
+ */
+struct dls_tiling {
+	const struct dls_circuit* circuit;
+	struct tile* tiles;
+	int num_tiles;
+	int tile_gates;
+	int block_words;
+	int* spill_row;
+	int num_spill;
+	uint64_t* spill;
+	struct dls_state* state;
+};
+
+/*
+ * Function: cacheSize
+ *
+ * returns: The size in bytes of the L2 cache, or DEFAULT_L2 if unknown
+ */
+static long cacheSize(void) {
+	long size = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+	return (size > 0) ? size : DEFAULT_L2;
+}
+
+/*
+ * Function: buildTiles
+ *
+ * Cuts the gates into tiles and works out the nets each tile must spill
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int buildTiles(struct dls_tiling* t) {
+	const struct dls_circuit* c = t->circuit;
+	int n = c->num_gates;
+	t->num_tiles = (n + t->tile_gates - 1)/t->tile_gates;
+	t->tiles = calloc(t->num_tiles + 1, sizeof(struct tile));
+	int* producer = malloc(c->num_nets*sizeof(int)); //Tile writing each slot, -1 for sources
+	int* seen = malloc(c->num_nets*sizeof(int)); //Last tile that listed the slot
+	t->spill_row = malloc(c->num_nets*sizeof(int));
+	if(t->tiles == NULL || producer == NULL || seen == NULL || t->spill_row == NULL) {
+		free(producer);
+		free(seen);
+		return DLS_ERR_NOMEM;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		producer[i] = -1;
+		seen[i] = -1;
+		t->spill_row[i] = -1;
+	}
+	for(int k = 0; k < t->num_tiles; k++) {
+		t->tiles[k].first = k*t->tile_gates;
+		t->tiles[k].last = (k + 1 == t->num_tiles) ? n : (k + 1)*t->tile_gates;
+		for(int i = t->tiles[k].first; i < t->tiles[k].last; i++) {
+			const struct gate* g = &c->gates[c->order[i]];
+			for(int o = 0; o < g->num_outputs; o++) {
+				producer[g->outputs[o]] = k;
+			}
+		}
+	}
+	/*Inputs and outputs always go through the spill buffer*/
+	for(int i = 0; i < c->num_inputs; i++) {
+		if(t->spill_row[c->inputs[i]] == -1) {
+			t->spill_row[c->inputs[i]] = t->num_spill++;
+		}
+	}
+	for(int o = 0; o < c->num_outputs; o++) {
+		if(t->spill_row[c->outputs[o]] == -1) {
+			t->spill_row[c->outputs[o]] = t->num_spill++;
+		}
+	}
+	/*A net read by a later tile, or an input read by any tile, is spilled*/
+	int rc = DLS_OK;
+	for(int k = 0; k < t->num_tiles && rc == DLS_OK; k++) {
+		struct tile* tl = &t->tiles[k];
+		int cap = 16;
+		tl->reads = malloc(cap*sizeof(int));
+		for(int i = tl->first; i < tl->last && tl->reads != NULL; i++) {
+			const struct gate* g = &c->gates[c->order[i]];
+			int fanin = gateNumFanin(g);
+			for(int f = 0; f < fanin; f++) {
+				int net = gateFanin(g, f);
+				bool boundary = (producer[net] >= 0 && producer[net] != k) || (producer[net] == -1 && t->spill_row[net] >= 0);
+				if(!boundary || seen[net] == k) {
+					continue;
+				}
+				seen[net] = k;
+				if(t->spill_row[net] == -1) {
+					t->spill_row[net] = t->num_spill++;
+				}
+				if(tl->num_reads == cap) {
+					cap *= 2;
+					int* grown = realloc(tl->reads, cap*sizeof(int));
+					if(grown == NULL) {
+						free(tl->reads);
+					}
+					tl->reads = grown;
+					if(grown == NULL) {
+						break;
+					}
+				}
+				tl->reads[tl->num_reads++] = net;
+			}
+		}
+		if(tl->reads == NULL) {
+			rc = DLS_ERR_NOMEM;
+		}
+	}
+	/*Every spilled net a tile produces is written back after each word*/
+	for(int k = 0; k < t->num_tiles && rc == DLS_OK; k++) {
+		struct tile* tl = &t->tiles[k];
+		int outputs = 0;
+		for(int i = tl->first; i < tl->last; i++) {
+			outputs += c->gates[c->order[i]].num_outputs;
+		}
+		tl->writes = malloc((outputs + 1)*sizeof(int));
+		if(tl->writes == NULL) {
+			rc = DLS_ERR_NOMEM;
+			break;
+		}
+		for(int i = tl->first; i < tl->last; i++) {
+			const struct gate* g = &c->gates[c->order[i]];
+			for(int o = 0; o < g->num_outputs; o++) {
+				if(t->spill_row[g->outputs[o]] >= 0) {
+					tl->writes[tl->num_writes++] = g->outputs[o];
+				}
+			}
+		}
+	}
+	free(producer);
+	free(seen);
+	return rc;
+}
+
+/*
+ * Function: dlsTilingNew
+ *
+ * Plans cache-blocked evaluation of a compiled circuit
+ * Tiles hold as many gates as fit in half of L2, and blocks as many words as let a
+ * tile's spill rows fit in the other half, in whole cache lines
+ *
+ * c: The compiled circuit
+ *
+ * l2: L2 cache size in bytes, 0 to detect it
+ *
+ * returns: The tiling, or NULL if the circuit is not compiled or out of memory
+ */
+struct dls_tiling* dlsTilingNew(const struct dls_circuit* c, long l2) {
+	if(c == NULL || !c->compiled) {
+		return NULL;
+	}
+	if(l2 <= 0) {
+		l2 = cacheSize();
+	}
+	struct dls_tiling* t = calloc(1, sizeof(struct dls_tiling));
+	if(t == NULL) {
+		return NULL;
+	}
+	t->circuit = c;
+	t->tile_gates = (int)(l2/2/BYTES_PER_GATE);
+	if(t->tile_gates < MIN_TILE_GATES) {
+		t->tile_gates = MIN_TILE_GATES;
+	}
+	t->state = dlsStateNew(c);
+	if(t->state == NULL || buildTiles(t) != DLS_OK) {
+		dlsTilingFree(t);
+		return NULL;
+	}
+	int widest = 1; //Most spill rows touched by one tile
+	for(int k = 0; k < t->num_tiles; k++) {
+		int rows = t->tiles[k].num_reads + t->tiles[k].num_writes;
+		if(rows > widest) {
+			widest = rows;
+		}
+	}
+	long words = l2/2/((long)widest*sizeof(uint64_t));
+	t->block_words = (words < MIN_BLOCK_WORDS) ? MIN_BLOCK_WORDS : (words > MAX_BLOCK_WORDS) ? MAX_BLOCK_WORDS : (int)words;
+	t->block_words &= ~(MIN_BLOCK_WORDS - 1); //Whole cache lines per row
+	t->spill = malloc(((size_t)t->num_spill*t->block_words + 1)*sizeof(uint64_t));
+	if(t->spill == NULL) {
+		dlsTilingFree(t);
+		return NULL;
+	}
+	return t;
+}
+
+/*
+ * Function: dlsTilingFree
+ *
+ * Releases a tiling
+ *
+ */
+void dlsTilingFree(struct dls_tiling* t) {
+	if(t == NULL) {
+		return;
+	}
+	for(int k = 0; t->tiles != NULL && k < t->num_tiles; k++) {
+		free(t->tiles[k].reads);
+		free(t->tiles[k].writes);
+	}
+	free(t->tiles);
+	free(t->spill_row);
+	free(t->spill);
+	dlsStateFree(t->state);
+	free(t);
+}
+
+int dlsTilingNumTiles(const struct dls_tiling* t) {
+	return t->num_tiles;
+}
+
+int dlsTilingTileGates(const struct dls_tiling* t) {
+	return t->tile_gates;
+}
+
+int dlsTilingBlockWords(const struct dls_tiling* t) {
+	return t->block_words;
+}
+
+int dlsTilingNumSpilled(const struct dls_tiling* t) {
+	return t->num_spill;
+}
+
+/*
+ * Function: dlsTilingEval
+ *
+ * Evaluates any number of words tile by tile, flip-flops held at 0
+ *
+ * t: The tiling
+ *
+ * words: Number of words
+ *
+ * in: words*dlsNumInputs words, the input words of word k start at in[k*dlsNumInputs]
+ *
+ * out: words*dlsNumOutputs words, filled the same way with the output words
+ *
+ */
+void dlsTilingEval(struct dls_tiling* t, long words, const uint64_t* in, uint64_t* out) {
+	const struct dls_circuit* c = t->circuit;
+	struct dls_state* s = t->state;
+	uint64_t* v = s->nets;
+	int ni = c->num_inputs;
+	int no = c->num_outputs;
+	int bw = t->block_words;
+	for(long base = 0; base < words; base += bw) {
+		int count = (words - base < bw) ? (int)(words - base) : bw;
+		for(int o = 0; o < no; o++) { //Outputs no gate drives, overwritten below for inputs
+			uint64_t* row = t->spill + (size_t)t->spill_row[c->outputs[o]]*bw;
+			for(int w = 0; w < count; w++) {
+				row[w] = v[c->outputs[o]];
+			}
+		}
+		for(int i = 0; i < ni; i++) {
+			uint64_t* row = t->spill + (size_t)t->spill_row[c->inputs[i]]*bw;
+			for(int w = 0; w < count; w++) {
+				row[w] = in[(base + w)*ni + i];
+			}
+		}
+		for(int k = 0; k < t->num_tiles; k++) {
+			const struct tile* tl = &t->tiles[k];
+			for(int w = 0; w < count; w++) {
+				for(int r = 0; r < tl->num_reads; r++) {
+					v[tl->reads[r]] = t->spill[(size_t)t->spill_row[tl->reads[r]]*bw + w];
+				}
+				for(int i = tl->first; i < tl->last; i++) {
+					const struct gate* g = &c->gates[c->order[i]];
+					if(g->oper == OP_INSTANCE) {
+						evalInstance(g, v, s->subs);
+					}
+					else {
+						evalGate(g, v, s->scratch);
+					}
+				}
+				for(int r = 0; r < tl->num_writes; r++) {
+					t->spill[(size_t)t->spill_row[tl->writes[r]]*bw + w] = v[tl->writes[r]];
+				}
+			}
+		}
+		for(int o = 0; o < no; o++) {
+			const uint64_t* row = t->spill + (size_t)t->spill_row[c->outputs[o]]*bw;
+			for(int w = 0; w < count; w++) {
+				out[(base + w)*no + o] = row[w];
+			}
+		}
+	}
+}
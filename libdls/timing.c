@@ -0,0 +1,517 @@
+#include<stdlib.h>
+#include<string.h>
+#include "dls_internal.h"
+
+/*
+ * Event-driven timing simulation
+ *
+ * Every gate has an integer delay, taken from its type unless set for the gate
+ * itself. A change of a net at time t evaluates the gates it feeds, and each new
+ * output value is scheduled at t plus the gate's delay (transport delay, so short
+ * pulses are kept and counted as glitches). Pending events sit in a timing wheel
+ * with one bucket per time step; since every delay is shorter than the wheel, an
+ * event never wraps past the bucket being drained. Events come from a pool that
+ * grows by whole chunks and recycles them through a free list.
+ *
+ * The gray code sweep is cut into 64 runs of consecutive rows, one per lane. The
+ * k-th transition of every run flips the same input except at the run's last
+ * step, so each word event carries up to 64 independent simulations at once.
+ */
+
+/*Longest delay accepted*/
+#define MAX_DELAY 65535
+
+/*Events allocated at a time*/
+#define EVENT_CHUNK 1024
+
+/*
+ * Structure: event
+ *
+ * A net taking a new word at a point in time
+ *
+ */
+struct event {
+	struct event* next;
+	uint64_t value;
+	int net;
+};
+
+/*
+ * Structure: dls_timing
+ *
+ * The delays of a compiled circuit and what the sweep needs to run it
+ *
+ * type_delay: Delay of each gate type, indexed by OP_ value
+ *
+ * gate_delay: Delay set for each gate, 0 to use its type's
+ *
+ * delay: Delay of each gate, resolved when a sweep starts
+ *
+ * driver: Slot to the gate driving it, -1 for inputs, constants and flip-flops
+ *
+ * fan_start, fan_gate: The gates reading slot s are fan_gate[fan_start[s]] to
+ *	fan_gate[fan_start[s+1]-1]
+ *
+ * out_index: Slot to the first output listing it, -1 for other nets
+ *
+ * wheel, wheel_tail: The buckets of the wheel, first and last event of each
+ *
+ * free_events, chunks: The event pool, its free list and the chunks it was cut from
+ *
+ */
+struct dls_timing {
+	const struct dls_circuit* circuit;
+	int type_delay[OP_MULTIPLEXER + 1];
+	int* gate_delay;
+	int* delay;
+	int* driver;
+	int* fan_start;
+	int* fan_gate;
+	int* out_index;
+	struct event** wheel;
+	struct event** wheel_tail;
+	int wheel_size;
+	long pending;
+	struct event* free_events;
+	struct event** chunks;
+	int num_chunks;
+	uint64_t events;
+};
+
+/*
+ * Function: dlsTimingNew
+ *
+ * Prepares timing simulation of a compiled circuit, every gate type with a delay of 1
+ *
+ * returns: The timing, or NULL if out of memory, the circuit is not compiled,
+ *	or it still holds module instances
+ */
+struct dls_timing* dlsTimingNew(const struct dls_circuit* c) {
+	if(c == NULL || !c->compiled) {
+		return NULL;
+	}
+	for(int k = 0; k < c->num_gates; k++) {
+		if(c->gates[k].oper == OP_INSTANCE) {
+			return NULL;
+		}
+	}
+	struct dls_timing* t = calloc(1, sizeof(struct dls_timing));
+	if(t == NULL) {
+		return NULL;
+	}
+	t->circuit = c;
+	for(int op = 0; op <= OP_MULTIPLEXER; op++) {
+		t->type_delay[op] = 1;
+	}
+	t->gate_delay = calloc(c->num_gates + 1, sizeof(int));
+	t->driver = malloc(c->num_nets*sizeof(int));
+	t->fan_start = calloc(c->num_nets + 1, sizeof(int));
+	t->out_index = malloc(c->num_nets*sizeof(int));
+	if(t->gate_delay == NULL || t->driver == NULL || t->fan_start == NULL || t->out_index == NULL) {
+		dlsTimingFree(t);
+		return NULL;
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		t->driver[i] = -1;
+		t->out_index[i] = -1;
+	}
+	for(int o = c->num_outputs - 1; o >= 0; o--) {
+		t->out_index[c->outputs[o]] = o;
+	}
+	/*Count the fanout of every slot, then fill it in*/
+	for(int k = 0; k < c->num_gates; k++) {
+		const struct gate* g = &c->gates[k];
+		int fanin = gateNumFanin(g);
+		for(int f = 0; f < fanin; f++) {
+			t->fan_start[gateFanin(g, f) + 1]++;
+		}
+		for(int o = 0; o < g->num_outputs; o++) {
+			t->driver[g->outputs[o]] = k;
+		}
+	}
+	for(int i = 0; i < c->num_nets; i++) {
+		t->fan_start[i + 1] += t->fan_start[i];
+	}
+	t->fan_gate = malloc((t->fan_start[c->num_nets] + 1)*sizeof(int));
+	int* fill = malloc((c->num_nets + 1)*sizeof(int));
+	if(t->fan_gate == NULL || fill == NULL) {
+		free(fill);
+		dlsTimingFree(t);
+		return NULL;
+	}
+	memcpy(fill, t->fan_start, c->num_nets*sizeof(int));
+	for(int k = 0; k < c->num_gates; k++) {
+		const struct gate* g = &c->gates[k];
+		int fanin = gateNumFanin(g);
+		for(int f = 0; f < fanin; f++) {
+			int net = gateFanin(g, f);
+			t->fan_gate[fill[net]++] = k;
+		}
+	}
+	free(fill);
+	return t;
+}
+
+void dlsTimingFree(struct dls_timing* t) {
+	if(t == NULL) {
+		return;
+	}
+	for(int i = 0; i < t->num_chunks; i++) {
+		free(t->chunks[i]);
+	}
+	free(t->chunks);
+	free(t->wheel);
+	free(t->wheel_tail);
+	free(t->gate_delay);
+	free(t->delay);
+	free(t->driver);
+	free(t->fan_start);
+	free(t->fan_gate);
+	free(t->out_index);
+	free(t);
+}
+
+/*
+ * Function: dlsTimingSetTypeDelay
+ *
+ * Sets the delay of every gate of a type that has no delay of its own
+ *
+ * type: NOT, AND, OR, NAND, NOR, XOR, XNOR, DECODER or MULTIPLEXER
+ *
+ * delay: 1 to 65535 time units
+ *
+ * returns: DLS_OK, or DLS_ERR_ARG for an unknown type or a delay out of range
+ */
+int dlsTimingSetTypeDelay(struct dls_timing* t, const char* type, int delay) {
+	if(delay < 1 || delay > MAX_DELAY) {
+		return DLS_ERR_ARG;
+	}
+	for(int op = 0; op <= OP_MULTIPLEXER; op++) {
+		if(strcmp(type, dlsGateTypeName(op)) == 0) {
+			t->type_delay[op] = delay;
+			return DLS_OK;
+		}
+	}
+	return DLS_ERR_ARG;
+}
+
+/*
+ * Function: dlsTimingSetDelay
+ *
+ * Sets the delay of one gate, overriding its type's
+ *
+ * net: Net id of any output of the gate
+ *
+ * delay: 1 to 65535 time units
+ *
+ * returns: DLS_OK, or DLS_ERR_ARG if no gate drives the net or the delay is out of range
+ */
+int dlsTimingSetDelay(struct dls_timing* t, int net, int delay) {
+	const struct dls_circuit* c = t->circuit;
+	if(net < 0 || net >= c->num_nets || delay < 1 || delay > MAX_DELAY || t->driver[c->net_slot[net]] < 0) {
+		return DLS_ERR_ARG;
+	}
+	t->gate_delay[t->driver[c->net_slot[net]]] = delay;
+	return DLS_OK;
+}
+
+uint64_t dlsTimingNumEvents(const struct dls_timing* t) {
+	return t->events;
+}
+
+/*
+ * Function: schedule
+ *
+ * Queues a net change at a time, behind the ones already queued for that time
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int schedule(struct dls_timing* t, long when, int net, uint64_t value) {
+	if(t->free_events == NULL) {
+		struct event* chunk = malloc(EVENT_CHUNK*sizeof(struct event));
+		struct event** chunks = realloc(t->chunks, (t->num_chunks + 1)*sizeof(struct event*));
+		if(chunks != NULL) {
+			t->chunks = chunks;
+		}
+		if(chunk == NULL || chunks == NULL) {
+			free(chunk);
+			return DLS_ERR_NOMEM;
+		}
+		t->chunks[t->num_chunks++] = chunk;
+		for(int i = 0; i < EVENT_CHUNK; i++) {
+			chunk[i].next = t->free_events;
+			t->free_events = &chunk[i];
+		}
+	}
+	struct event* e = t->free_events;
+	t->free_events = e->next;
+	e->next = NULL;
+	e->value = value;
+	e->net = net;
+	int b = (int)(when & (t->wheel_size - 1));
+	if(t->wheel[b] == NULL) {
+		t->wheel[b] = e;
+	}
+	else {
+		t->wheel_tail[b]->next = e;
+	}
+	t->wheel_tail[b] = e;
+	t->pending++;
+	return DLS_OK;
+}
+
+/*
+ * Function: evalTimed
+ *
+ * Evaluates one gate from the current net words and schedules the outputs that
+ * differ from the last value scheduled for them
+ *
+ * cur: Current net words
+ *
+ * proj: Last value scheduled for each net, and the hot words of the wide decoders
+ *
+ * save: Room for the gate's output words
+ *
+ * returns: DLS_OK or DLS_ERR_NOMEM
+ */
+static int evalTimed(struct dls_timing* t, int k, long now, uint64_t* cur, uint64_t* proj, uint64_t* scratch, uint64_t* save) {
+	const struct gate* g = &t->circuit->gates[k];
+	long when = now + t->delay[k];
+	int rc = DLS_OK;
+	if(g->hot >= 0) { //Only the outputs of lanes whose code changed are touched
+		uint64_t code[64] = {0};
+		uint64_t* hot = &proj[g->hot];
+		for(int i = 0; i < g->num_inputs; i++) {
+			uint64_t s = cur[g->inputs[i]];
+			for(int lane = 0; lane < 64; lane++) {
+				code[lane] = (code[lane] << 1) | ((s >> lane) & 1);
+			}
+		}
+		for(int lane = 0; lane < 64 && rc == DLS_OK; lane++) {
+			uint64_t l = grayToBinary64(code[lane]);
+			if(l == hot[lane]) {
+				continue;
+			}
+			int from = g->outputs[hot[lane]];
+			int to = g->outputs[l];
+			proj[from] &= ~((uint64_t)1 << lane);
+			proj[to] |= (uint64_t)1 << lane;
+			hot[lane] = l;
+			rc = schedule(t, when, from, proj[from]);
+			if(rc == DLS_OK) {
+				rc = schedule(t, when, to, proj[to]);
+			}
+		}
+		return rc;
+	}
+	for(int o = 0; o < g->num_outputs; o++) {
+		save[o] = cur[g->outputs[o]];
+	}
+	evalGate(g, cur, scratch);
+	for(int o = 0; o < g->num_outputs; o++) {
+		int net = g->outputs[o];
+		uint64_t value = cur[net];
+		cur[net] = save[o];
+		if(value != proj[net] && rc == DLS_OK) {
+			proj[net] = value;
+			rc = schedule(t, when, net, value);
+		}
+	}
+	return rc;
+}
+
+/*
+ * Function: dlsTimingSweep
+ *
+ * Applies every transition of the gray code sweep in turn, each starting from the
+ * settled values of the previous row, and measures the outputs
+ * Flip-flops are held at 0
+ *
+ * t: The timing
+ *
+ * stats: dlsNumOutputs entries, filled in for each output
+ *
+ * returns: DLS_OK, DLS_ERR_ARG if the sweep is too wide, or DLS_ERR_NOMEM
+ */
+int dlsTimingSweep(struct dls_timing* t, struct dls_timing_stats* stats) {
+	const struct dls_circuit* c = t->circuit;
+	int n = c->num_inputs;
+	int no = c->num_outputs;
+	if(n > 63) {
+		return DLS_ERR_ARG;
+	}
+	free(t->delay);
+	t->delay = malloc((c->num_gates + 1)*sizeof(int));
+	if(t->delay == NULL) {
+		return DLS_ERR_NOMEM;
+	}
+	int longest = 1;
+	for(int k = 0; k < c->num_gates; k++) {
+		t->delay[k] = (t->gate_delay[k] != 0) ? t->gate_delay[k] : t->type_delay[c->gates[k].oper];
+		if(t->delay[k] > longest) {
+			longest = t->delay[k];
+		}
+	}
+	int size = 2;
+	while(size <= longest) {
+		size *= 2;
+	}
+	free(t->wheel);
+	free(t->wheel_tail);
+	t->wheel = calloc(size, sizeof(struct event*));
+	t->wheel_tail = calloc(size, sizeof(struct event*));
+	t->wheel_size = size;
+	t->pending = 0;
+	t->events = 0;
+	int max_outputs = 1;
+	for(int k = 0; k < c->num_gates; k++) {
+		if(c->gates[k].num_outputs > max_outputs) {
+			max_outputs = c->gates[k].num_outputs;
+		}
+	}
+	struct dls_state* s = dlsStateNew(c);
+	uint64_t* proj = malloc(c->num_words*sizeof(uint64_t));
+	uint64_t* save = malloc(max_outputs*sizeof(uint64_t));
+	uint64_t* stamp = calloc(c->num_gates + 1, sizeof(uint64_t)); //Last time step each gate was queued
+	int* queue = malloc((c->num_gates + 1)*sizeof(int));
+	uint64_t* before = malloc((no + 1)*sizeof(uint64_t)); //Output words when the step starts
+	uint64_t* moved = malloc((no + 1)*sizeof(uint64_t)); //Lanes in which each output changed this step
+	uint64_t* flips = malloc((no + 1)*sizeof(uint64_t)); //Transitions of each output this step
+	long* last = malloc((64*(size_t)no + 1)*sizeof(long)); //Time of the last transition of each output and lane
+	double* settle_sum = calloc(no + 1, sizeof(double));
+	if(t->wheel == NULL || t->wheel_tail == NULL || s == NULL || proj == NULL || save == NULL || stamp == NULL || queue == NULL
+			|| before == NULL || moved == NULL || flips == NULL || last == NULL || settle_sum == NULL) {
+		dlsStateFree(s);
+		free(proj);
+		free(save);
+		free(stamp);
+		free(queue);
+		free(before);
+		free(moved);
+		free(flips);
+		free(last);
+		free(settle_sum);
+		return DLS_ERR_NOMEM;
+	}
+	memset(stats, 0, no*sizeof(struct dls_timing_stats));
+	uint64_t rows = (uint64_t)1 << n;
+	int lanes = (rows < 64) ? (int)rows : 64;
+	uint64_t run = rows/lanes; //Rows per lane
+	/*Lane k starts settled at row k*run*/
+	uint64_t* v = s->nets;
+	for(int j = 0; j < n; j++) {
+		uint64_t word = 0;
+		for(int k = 0; k < lanes; k++) {
+			uint64_t row = k*run;
+			word |= (((row ^ (row >> 1)) >> sweepBit(c, j)) & 1) << k;
+		}
+		v[c->inputs[j]] = word;
+	}
+	dlsEvalWords(c, s);
+	memcpy(proj, v, c->num_words*sizeof(uint64_t));
+	uint64_t epoch = 0;
+	int rc = DLS_OK;
+	for(uint64_t step = 1; step <= run && n > 0 && rc == DLS_OK; step++) {
+		/*Flip the input of this step in every lane, at time 0*/
+		for(int o = 0; o < no; o++) {
+			before[o] = v[c->outputs[o]];
+			moved[o] = 0;
+			flips[o] = 0;
+		}
+		if(step < run) {
+			int j = sweepInput(c, __builtin_ctzll(step));
+			uint64_t mask = (lanes == 64) ? ~(uint64_t)0 : (((uint64_t)1 << lanes) - 1);
+			proj[c->inputs[j]] = v[c->inputs[j]] ^ mask;
+			rc = schedule(t, 0, c->inputs[j], proj[c->inputs[j]]);
+		}
+		else {
+			for(int k = 0; k + 1 < lanes && rc == DLS_OK; k++) { //The last lane ends with the sweep
+				int j = sweepInput(c, __builtin_ctzll((k + 1)*run));
+				proj[c->inputs[j]] ^= (uint64_t)1 << k;
+				rc = schedule(t, 0, c->inputs[j], proj[c->inputs[j]]);
+			}
+		}
+		for(long now = 0; t->pending > 0 && rc == DLS_OK; now++) {
+			int b = (int)(now & (size - 1));
+			struct event* e = t->wheel[b];
+			t->wheel[b] = NULL;
+			int queued = 0;
+			epoch++;
+			while(e != NULL) {
+				struct event* next = e->next;
+				uint64_t diff = e->value ^ v[e->net];
+				if(diff != 0) {
+					v[e->net] = e->value;
+					t->events++;
+					int o = t->out_index[e->net];
+					if(o >= 0) {
+						moved[o] |= diff;
+						flips[o] += __builtin_popcountll(diff);
+						for(uint64_t d = diff; d != 0; d &= d - 1) {
+							last[64*(size_t)o + __builtin_ctzll(d)] = now;
+						}
+					}
+					for(int f = t->fan_start[e->net]; f < t->fan_start[e->net + 1]; f++) {
+						int k = t->fan_gate[f];
+						if(stamp[k] != epoch) {
+							stamp[k] = epoch;
+							queue[queued++] = k;
+						}
+					}
+				}
+				e->next = t->free_events;
+				t->free_events = e;
+				t->pending--;
+				e = next;
+			}
+			for(int q = 0; q < queued && rc == DLS_OK; q++) {
+				rc = evalTimed(t, queue[q], now, v, proj, s->scratch, save);
+			}
+		}
+		for(int o = 0; o < no; o++) {
+			if(moved[o] == 0) {
+				continue;
+			}
+			struct dls_timing_stats* st = &stats[o];
+			st->transitions += flips[o];
+			st->glitches += flips[o] - __builtin_popcountll(before[o] ^ v[c->outputs[o]]);
+			for(uint64_t d = moved[o]; d != 0; d &= d - 1) {
+				long when = last[64*(size_t)o + __builtin_ctzll(d)];
+				st->steps++;
+				settle_sum[o] += when;
+				if(when > st->max_settle) {
+					st->max_settle = when;
+				}
+			}
+		}
+	}
+	for(int o = 0; o < no; o++) {
+		if(t->out_index[c->outputs[o]] != o) { //Listed twice, counted under its first position
+			stats[o] = stats[t->out_index[c->outputs[o]]];
+		}
+		else if(stats[o].steps > 0) {
+			stats[o].mean_settle = settle_sum[o]/stats[o].steps;
+		}
+	}
+	/*Drop whatever an allocation failure left queued*/
+	for(int b = 0; b < size; b++) {
+		while(t->wheel[b] != NULL) {
+			struct event* e = t->wheel[b];
+			t->wheel[b] = e->next;
+			e->next = t->free_events;
+			t->free_events = e;
+		}
+	}
+	t->pending = 0;
+	dlsStateFree(s);
+	free(proj);
+	free(save);
+	free(stamp);
+	free(queue);
+	free(before);
+	free(moved);
+	free(flips);
+	free(last);
+	free(settle_sum);
+	return rc;
+}
@@ -69,8 +69,8 @@ void insertLine(int oper, int num_inputs, int num_outputs, char** inputs, char**
 		strcpy(out[i], outputs[i]);
 	}
 	if(multi != NULL) {
-		char** mul = malloc((1 << num_inputs)*sizeof(char*));
-		for(int i = 0; i < (1 << num_inputs); i++) {
+		char** mul = malloc(((uint64_t)1 << num_inputs)*sizeof(char*));
+		for(uint64_t i = 0; i < ((uint64_t)1 << num_inputs); i++) {
 			mul[i] = malloc(32*sizeof(char));
 			strcpy(mul[i], multi[i]);
 		}
@@ -84,6 +84,7 @@ void insertLine(int oper, int num_inputs, int num_outputs, char** inputs, char**
 	temp->num_outputs = num_outputs;
 	temp->inputs = in;
 	temp->outputs = out;
+	temp->hot = -1;
 	temp->next = NULL;
 	if(linehead == NULL) {
 		linehead = temp;
@@ -326,10 +327,10 @@ bool getDone(char* name) {
   *
   * num_inputs: The number of inputs
   *
-  * returns: An int with the corresponding outputs in binary
+  * returns: The index of the output set to 1
   */
-int myDecoder(int* in, int num_inputs) {
-	int code = 0;
+uint64_t myDecoder(int* in, int num_inputs) {
+	uint64_t code = 0;
 	for(int i = 0; i < num_inputs; i++) {
 		code = code << 1;
 		code = code + in[i];
@@ -353,7 +354,7 @@ int myDecoder(int* in, int num_inputs) {
  * returns: The value of the selected input
  */
 int myMultiplexer(int* encoding, int* in, int num_inputs) {
-	int code = 0;
+	uint64_t code = 0;
 	for(int i = 0; i < num_inputs; i++) {
 		code = code << 1;
 		code = code + in[i];
@@ -364,48 +365,35 @@ int myMultiplexer(int* encoding, int* in, int num_inputs) {
 /*
  * Function: grayToBinary
  *
- * Converts gray code stored as an int to binary stored as a int
+ * Converts gray code to binary
+ * Each step folds in twice as many higher bits, so it takes six shifts for any input
  *
- * in: Gray code stored as an int
+ * in: Gray code
  *
- * returns: Binary stored as an int
+ * returns: Binary
  */
-int grayToBinary(int in) {
-	int temp = in;
-	while(in >>= 1) temp ^= in;
-	return temp;
+uint64_t grayToBinary(uint64_t in) {
+	in ^= in >> 1;
+	in ^= in >> 2;
+	in ^= in >> 4;
+	in ^= in >> 8;
+	in ^= in >> 16;
+	in ^= in >> 32;
+	return in;
 }
 
 /*
  * Function: binaryToGray
  *
- * Converts binary stored as an in to gray code stored as an int
+ * Converts binary to gray code
+ * Row i of the truth table applies binaryToGray(i), so the sweep needs no table of codes
  *
- * in: Binary stored as an int
+ * in: Binary
  *
- * returns: Gray code stored as an int
+ * returns: Gray code
  */
-int binaryToGray(int in) {
-	return in ^ (in-1);
-}
-
-/*
- * Function: genGrayCode
- *
- * Generates a sequence of gray code
- *
- * bits: Number of bits
- * 	Generates 2^bits gray code numbers
- *
- * returns: An array of ints, with the sequence of gray code
- */
-int* genGrayCode(int bits) {
-	int n = 2 << (bits-1);
-	int* ret = malloc(n*sizeof(int));
-	for(int i = 0; i < n; i++) {
-		ret[i] = i ^ (i>>1);
-	}
-	return ret;
+uint64_t binaryToGray(uint64_t in) {
+	return in ^ (in >> 1);
 }
 
 /*
@@ -621,11 +609,15 @@ void makeXnor(FILE* datafile) {
 void makeDecoder(FILE* datafile) {
 	int num_inputs = 0;
 	fscanf(datafile, " %d", &num_inputs);
+	if(num_inputs < 0 || num_inputs > MAX_SELECTS) {
+		printf("error");
+		exit(0);
+	}
 	char** in = malloc(num_inputs*sizeof(char*));
 	for(int i = 0; i < num_inputs; i++) {
 		in[i] = malloc(32*sizeof(char));
 	}
-	int num_outputs = (1 << num_inputs);
+	int num_outputs = (int)((uint64_t)1 << num_inputs);
 	char** out = malloc(num_outputs*sizeof(char*));
 	for(int i = 0; i < num_outputs; i++) {
 		out[i] = malloc(32*sizeof(char));
@@ -654,7 +646,11 @@ void makeMultiplexer(FILE* datafile) {
 	int num_inputs = 0;
 	fscanf(datafile, " %d", &num_inputs);
 	int num_multi = num_inputs;
-	num_inputs = log_2(num_inputs);;
+	num_inputs = log_2(num_inputs); //Negative unless num_multi is a power of two
+	if(num_inputs < 0 || num_inputs > MAX_SELECTS) {
+		printf("error");
+		exit(0);
+	}
 	char** in = malloc(num_inputs*sizeof(char*));
 	for(int i = 0; i < num_inputs; i++) {
 		in[i] = malloc(32*sizeof(char));
@@ -778,7 +774,7 @@ int main(int argc, char** argv) {
 	int n_in = 0;
 	int n_out = 0;
 	bool done = true;
-	int n_multi = 0;
+	uint64_t n_multi = 0;
 
 	while(linehead != NULL) {
 		while(optr != NULL) { //Iterate through the unordered list and find a node that can be solved for
@@ -791,8 +787,8 @@ int main(int argc, char** argv) {
 			}
 			/*Need to check multiplexer as well for encoding*/
 			if(optr->oper == 8) {
-				n_multi = (1 << optr->num_inputs);
-				for(int c = 0; c < n_multi; c++) {
+				n_multi = ((uint64_t)1 << optr->num_inputs);
+				for(uint64_t c = 0; c < n_multi; c++) {
 					if(!getDone(optr->multi[c])) {
 						done = false;
 					}
@@ -820,13 +816,17 @@ int main(int argc, char** argv) {
 
 	linehead = orderhead;
 
-	/*Generate the input combinations*/
-	int* grayArray = genGrayCode(num_inputs);
+	/*Generate the input combinations, one gray code at a time*/
+	if(num_inputs > 63) {
+		printf("error");
+		exit(0);
+	}
 	int correctBit = 0;
-	for(int i = 0; i < (1 << (num_inputs)); i++) {
+	for(uint64_t i = 0; i < ((uint64_t)1 << num_inputs); i++) {
 		/*Set the inputs*/
+		uint64_t gray = binaryToGray(i);
 		for(int j = 0; j < num_inputs; j++) {
-		correctBit = ((grayArray[i] >> j) & 0x1);
+			correctBit = ((gray >> j) & 0x1);
 			inputArray[num_inputs-j-1]->value = correctBit;
 		}
 		/*Run through the circuit*/
@@ -885,21 +885,29 @@ int main(int argc, char** argv) {
 					for(int k = 0; k < ptr->num_inputs; k++) {
 						inputDecInt[k] = getValue(ptr->inputs[k]);
 					}
-					tempresult = myDecoder(inputDecInt, ptr->num_inputs);
-					for(int l = 0; l < (1 << (ptr->num_inputs)); l++) {
-						if(l == (tempresult)) {
-							setValue(ptr->outputs[l], 1);
-						}
-						else { //The 0's
-							setValue(ptr->outputs[l], 0);
+					uint64_t selected = myDecoder(inputDecInt, ptr->num_inputs);
+					free(inputDecInt);
+					if(ptr->num_inputs > SPARSE_SELECTS && ptr->hot >= 0) { //Only the old and the new output change
+						setValue(ptr->outputs[ptr->hot], 0);
+						setValue(ptr->outputs[selected], 1);
+					}
+					else {
+						for(uint64_t l = 0; l < ((uint64_t)1 << ptr->num_inputs); l++) {
+							if(l == selected) {
+								setValue(ptr->outputs[l], 1);
+							}
+							else { //The 0's
+								setValue(ptr->outputs[l], 0);
+							}
 						}
 					}
+					ptr->hot = (int64_t)selected;
 					break;
 					}
 				case 8: //MULTIPLEXER
 					{
-					int* encodingInt = malloc((1 << (ptr->num_inputs))*sizeof(int)); //Convert encoding to int
-					for(int k = 0; k < (1 << (ptr->num_inputs)); k++) {
+					int* encodingInt = malloc(((uint64_t)1 << ptr->num_inputs)*sizeof(int)); //Convert encoding to int
+					for(uint64_t k = 0; k < ((uint64_t)1 << ptr->num_inputs); k++) {
 						encodingInt[k] = getValue(ptr->multi[k]);
 					}
 					int* inputMultiInt = malloc(ptr->num_inputs*sizeof(int));
@@ -907,6 +915,8 @@ int main(int argc, char** argv) {
 						inputMultiInt[l] = getValue(ptr->inputs[l]);
 					}
 					tempresult = myMultiplexer(encodingInt, inputMultiInt, ptr->num_inputs);
+					free(encodingInt);
+					free(inputMultiInt);
 					setValue(ptr->outputs[0], tempresult);
 					break;
 					}
@@ -2,6 +2,13 @@
 #include<stdio.h>
 #include<string.h>
 #include<stdbool.h>
+#include<stdint.h>
+
+/*Decoders with more selects than this only update the outputs that change*/
+#define SPARSE_SELECTS 20
+
+/*Largest decoder or multiplexer select count, the same limit as libdls*/
+#define MAX_SELECTS 24
 
 /*
  * Structure: var
@@ -49,6 +56,8 @@ struct var {
  * multi: Only used for multiplexers (oper=8)
  *	Store the encoding of the the multiplexer
  *
+ * hot: Only used for decoders (oper=7), the output set to 1 last time, -1 before the first
+ *
  */
 struct line {
 	int oper;
@@ -57,6 +66,7 @@ struct line {
 	char** inputs; //For multiplexers: Store the selects
 	char** outputs;
 	char** multi; //For multiplexers: Store the encoding
+	int64_t hot;
 	struct line* next;
 };
 
@@ -77,11 +87,10 @@ int myNand(int, int);
 int myNor(int, int);
 int myXor(int, int);
 int myXnor(int, int);
-int myDecoder(int*, int);
+uint64_t myDecoder(int*, int);
 int myMultiplexer(int*, int*, int);
-int grayToBinary(int);
-int binaryToGray(int);
-int* genGrayCode(int);
+uint64_t grayToBinary(uint64_t);
+uint64_t binaryToGray(uint64_t);
 void makeNot(FILE*);
 void makeAnd(FILE*);
 void makeOr(FILE*);